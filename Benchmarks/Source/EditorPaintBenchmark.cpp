@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    Offscreen paint benchmark for the Obsidian Space editor.
+
+    Builds the real editor without a window, paints it into images at 1x and
+    2x while sweeping every slider and pumping the message loop, and prints
+    how long each part of the UI took to paint. With no window there is no
+    vblank, so the visualizer is stepped one frame per block of audio.
+
+    Usage: EditorPaintBenchmark [--frames N]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/PluginEditor.h"
+
+namespace
+{
+    double ticksToMs (juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds (ticks) * 1000.0;
+    }
+
+    juce::String describe (juce::Component& component)
+    {
+        if (dynamic_cast<HeaderComponent*> (&component) != nullptr)        return "Header";
+        if (dynamic_cast<VisualizerComponent*> (&component) != nullptr)    return "Visualizer";
+        if (dynamic_cast<DecayAnalyzerComponent*> (&component) != nullptr) return "Decay analyzer";
+        if (dynamic_cast<FooterComponent*> (&component) != nullptr)        return "Footer";
+        if (dynamic_cast<KnobControl*> (&component) != nullptr)            return "Knobs";
+        if (dynamic_cast<SliderPanel*> (&component) != nullptr)            return "Slider panels";
+        return "Other";
+    }
+
+    void findSliders (juce::Component& parent, juce::Array<juce::Slider*>& sliders)
+    {
+        for (auto* child : parent.getChildren())
+        {
+            if (auto* slider = dynamic_cast<juce::Slider*> (child))
+                sliders.add (slider);
+            else
+                findSliders (*child, sliders);
+        }
+    }
+
+    // Accumulates one row of results; parts with several instances, such as
+    // the four knobs, are summed per frame before they are added.
+    class PaintTimings
+    {
+    public:
+        void add (const juce::String& name, double milliseconds)
+        {
+            if (! rows.contains (name))
+                order.add (name);
+
+            rows.getReference (name).addValue (milliseconds);
+        }
+
+        void print (float scale) const
+        {
+            std::cout << juce::String::formatted ("\n%.0fx scale\n", (double) scale)
+                      << juce::String::formatted ("  %-26s %10s %10s %10s %8s\n", "component", "mean ms", "min ms", "max ms", "frames");
+
+            for (auto& name : order)
+            {
+                auto& stats = rows[name];
+                std::cout << juce::String::formatted ("  %-26s %10.3f %10.3f %10.3f %8d\n", name.toRawUTF8(),
+                                                      stats.getAverage(), stats.getMinValue(), stats.getMaxValue(),
+                                                      (int) stats.getCount());
+            }
+        }
+
+    private:
+        juce::StringArray order;
+        juce::HashMap<juce::String, juce::StatisticsAccumulator<double>> rows;
+    };
+
+    class EditorPaintBenchmark
+    {
+    public:
+        EditorPaintBenchmark (juce::AudioProcessorEditor& editorToPaint, ObsidianSpaceAudioProcessor& processorToRun)
+            : editor (editorToPaint), processor (processorToRun)
+        {
+            findSliders (editor, sliders);
+            audio.setSize (2, blockSize);
+
+            // Starts the wet signal flowing before the first block.
+            if (auto* visualizer = findChild<VisualizerComponent>())
+                visualizer->advanceFrameExternally (0.0);
+        }
+
+        void run (float scale, int numFrames)
+        {
+            image = juce::Image (juce::Image::ARGB,
+                                 juce::roundToInt ((float) editor.getWidth() * scale),
+                                 juce::roundToInt ((float) editor.getHeight() * scale), true);
+
+            PaintTimings timings;
+
+            // One untimed pass so every cached layer is built at this scale.
+            paintRegion (scale, editor.getLocalBounds());
+
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                processAudioBlock();
+                juce::MessageManager::getInstance()->runDispatchLoopUntil (1);
+
+                if (auto* visualizer = findChild<VisualizerComponent>())
+                    timings.add ("Visualizer frame update", advanceVisualizer (*visualizer));
+
+                timings.add ("Full editor", paintRegion (scale, editor.getLocalBounds()));
+                timings.add ("Editor background", paintEditorBackground (scale));
+
+                juce::HashMap<juce::String, double> perFrame;
+                juce::StringArray names;
+
+                for (auto* child : editor.getChildren())
+                {
+                    if (! child->isVisible())
+                        continue;
+
+                    const auto name = describe (*child);
+                    if (! perFrame.contains (name))
+                        names.add (name);
+
+                    perFrame.set (name, perFrame[name] + paintChild (scale, *child));
+                }
+
+                for (auto& name : names)
+                    timings.add (name, perFrame[name]);
+
+                if (auto* visualizer = findChild<VisualizerComponent>())
+                    timings.add ("Visualizer tick", paintRegion (scale, visualizer->getBounds()));
+
+                if (! sliders.isEmpty())
+                {
+                    auto* slider = sliders[(frame / dragFramesPerSlider) % sliders.size()];
+                    const auto isKnob = slider->getSliderStyle() == juce::Slider::RotaryHorizontalVerticalDrag;
+                    timings.add (isKnob ? "Knob drag repaint" : "Slider drag repaint", dragSlider (scale, *slider, frame));
+                }
+            }
+
+            timings.print (scale);
+        }
+
+    private:
+        template <typename ComponentType>
+        ComponentType* findChild() const
+        {
+            for (auto* child : editor.getChildren())
+                if (auto* match = dynamic_cast<ComponentType*> (child))
+                    return match;
+
+            return nullptr;
+        }
+
+        // Paints everything under a region, the way the windowing system
+        // would after a repaint of that region.
+        double paintRegion (float scale, juce::Rectangle<int> region)
+        {
+            juce::Graphics g (image);
+            g.addTransform (juce::AffineTransform::scale (scale));
+            g.reduceClipRegion (region);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            editor.paintEntireComponent (g, false);
+            return ticksToMs (juce::Time::getHighResolutionTicks() - start);
+        }
+
+        double paintEditorBackground (float scale)
+        {
+            juce::Graphics g (image);
+            g.addTransform (juce::AffineTransform::scale (scale));
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            editor.paint (g);
+            return ticksToMs (juce::Time::getHighResolutionTicks() - start);
+        }
+
+        double paintChild (float scale, juce::Component& child)
+        {
+            juce::Graphics g (image);
+            g.addTransform (juce::AffineTransform::scale (scale));
+            g.setOrigin (child.getPosition());
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            child.paintEntireComponent (g, false);
+            return ticksToMs (juce::Time::getHighResolutionTicks() - start);
+        }
+
+        // Moves one slider a step along a triangle sweep, then repaints the
+        // control it belongs to, which also covers its value box.
+        double dragSlider (float scale, juce::Slider& slider, int frame)
+        {
+            const auto step = frame % dragFramesPerSlider;
+            const auto position = 1.0 - std::abs (2.0 * step / (double) (dragFramesPerSlider - 1) - 1.0);
+            slider.setValue (slider.proportionOfLengthToValue (position), juce::sendNotificationSync);
+
+            auto& control = slider.getParentComponent() != nullptr ? *slider.getParentComponent() : slider;
+            return paintRegion (scale, editor.getLocalArea (&control, control.getLocalBounds()));
+        }
+
+        double advanceVisualizer (VisualizerComponent& visualizer)
+        {
+            const auto start = juce::Time::getHighResolutionTicks();
+            visualizer.advanceFrameExternally (1000.0 * blockSize / sampleRate);
+            return ticksToMs (juce::Time::getHighResolutionTicks() - start);
+        }
+
+        void processAudioBlock()
+        {
+            for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    audio.setSample (channel, i, (random.nextFloat() * 2.0f - 1.0f) * 0.25f);
+
+            processor.processBlock (audio, midi);
+        }
+
+        static constexpr int blockSize = 512;
+        static constexpr double sampleRate = 48000.0;
+        static constexpr int dragFramesPerSlider = 30;
+
+        juce::AudioProcessorEditor& editor;
+        ObsidianSpaceAudioProcessor& processor;
+        juce::Array<juce::Slider*> sliders;
+        juce::Image image;
+
+        juce::AudioBuffer<float> audio;
+        juce::MidiBuffer midi;
+        juce::Random random { 42 };
+    };
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args (argc, argv);
+    const auto numFrames = juce::jmax (1, args.containsOption ("--frames") ? args.getValueForOption ("--frames").getIntValue() : 300);
+
+    ObsidianSpaceAudioProcessor processor;
+    processor.setPlayConfigDetails (2, 2, 48000.0, 512);
+    processor.prepareToPlay (48000.0, 512);
+
+    {
+        std::unique_ptr<juce::AudioProcessorEditor> editor (processor.createEditorIfNeeded());
+        editor->setVisible (true);
+
+        std::cout << "Obsidian Space editor paint benchmark: " << editor->getWidth() << "x" << editor->getHeight()
+                  << ", " << numFrames << " frames per scale\n";
+
+        EditorPaintBenchmark benchmark (*editor, processor);
+
+        for (auto scale : { 1.0f, 2.0f })
+            benchmark.run (scale, numFrames);
+    }
+
+    processor.releaseResources();
+    return 0;
+}
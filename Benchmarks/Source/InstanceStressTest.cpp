@@ -0,0 +1,475 @@
+/*
+  ==============================================================================
+
+    Multi-instance stress test for the Obsidian Space processor.
+
+    Creates up to 512 processors and drives them from a pool of worker
+    threads the way multi-threaded hosts do: every cycle, each instance
+    processes one block, with the workers taking instances from a shared
+    counter and the cycle ending when all are done. Reports:
+
+      - resident memory per instance after construction, prepareToPlay and
+        the first block of audio, which is when the engines are allocated
+      - cost per block and DSP load as the instance count grows
+      - throughput scaling with the number of worker threads
+      - false sharing, by comparing tightly packed against padded instances,
+        instances whose heap blocks were allocated back to back against ones
+        with a spacer between them, and running with against without a
+        thread reading the meters the editor polls
+
+    Packing only moves the processor objects themselves. Their buffers and
+    delay lines live on the heap, so the heap comparison allocates every
+    instance in turn on one thread, which puts small blocks from
+    neighbouring instances next to each other, and then again with a spacer
+    block between instances. The allocator may still reuse freed blocks, so
+    a clean result there is a good sign rather than a proof.
+
+    Usage: InstanceStressTest [--max-instances N] [--threads N]
+                              [--block-size N] [--seconds S]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+#if JUCE_MAC
+ #include <mach/mach.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+ #include <psapi.h>
+ #pragma comment (lib, "psapi.lib")
+#endif
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    size_t getResidentBytes()
+    {
+       #if JUCE_LINUX || JUCE_BSD
+        auto fields = juce::StringArray::fromTokens (juce::File ("/proc/self/statm").loadFileAsString(), false);
+        return (size_t) fields[1].getLargeIntValue() * (size_t) sysconf (_SC_PAGESIZE);
+       #elif JUCE_MAC
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info (mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+            return 0;
+        return (size_t) info.resident_size;
+       #elif JUCE_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters;
+        if (! GetProcessMemoryInfo (GetCurrentProcess(), &counters, sizeof (counters)))
+            return 0;
+        return (size_t) counters.WorkingSetSize;
+       #else
+        return 0;
+       #endif
+    }
+
+    juce::String formatBytes (double bytes)
+    {
+        if (bytes >= 1024.0 * 1024.0)
+            return juce::String (bytes / (1024.0 * 1024.0), 2) + " MB";
+
+        return juce::String (bytes / 1024.0, 1) + " KB";
+    }
+
+    //==============================================================================
+    // A set of prepared processors, either packed back to back in one arena
+    // or each on its own pages with a guard gap, plus their audio buffers.
+    class InstanceSet
+    {
+    public:
+        enum class Layout { packed, padded };
+
+        // Where each instance's heap blocks go. lazy is what a host gets: the
+        // engines are allocated on the allocator thread once signal arrives.
+        // adjacent and separated allocate each instance in full on this thread
+        // during prepare, separated with a spacer block after each one.
+        enum class Heap { lazy, adjacent, separated };
+
+        InstanceSet (int numInstances, Layout layout, Heap heapLayout, int blockSize)
+            : heap (heapLayout)
+        {
+            using Processor = ObsidianSpaceAudioProcessor;
+            constexpr size_t alignment = alignof (Processor);
+            const auto stride = layout == Layout::packed
+                                    ? (sizeof (Processor) + alignment - 1) / alignment * alignment
+                                    : (sizeof (Processor) + 2 * guardBytes + pageBytes - 1) / pageBytes * pageBytes;
+
+            arena.calloc (stride * (size_t) numInstances + pageBytes);
+            auto base = (reinterpret_cast<size_t> (arena.get()) + pageBytes - 1) / pageBytes * pageBytes;
+
+            for (int i = 0; i < numInstances; ++i)
+            {
+                auto address = base + stride * (size_t) i + (layout == Layout::padded ? guardBytes : 0);
+                processors.push_back (new (reinterpret_cast<void*> (address)) Processor());
+            }
+
+            buffers.resize ((size_t) numInstances);
+        }
+
+        ~InstanceSet()
+        {
+            for (auto* processor : processors)
+            {
+                processor->releaseResources();
+                processor->~ObsidianSpaceAudioProcessor();
+            }
+        }
+
+        void prepare (int blockSize)
+        {
+            for (size_t i = 0; i < processors.size(); ++i)
+            {
+                auto* processor = processors[i];
+                processor->setPlayConfigDetails (2, 2, sampleRate, blockSize);
+
+                // Non-realtime prepares allocate the engines on this thread.
+                processor->setNonRealtime (heap != Heap::lazy);
+                processor->prepareToPlay (sampleRate, blockSize);
+                processor->setNonRealtime (false);
+
+                buffers[i].setSize (2, blockSize);
+
+                if (heap == Heap::separated)
+                    spacers.emplace_back (spacerBytes);
+            }
+        }
+
+        void process (int index, const juce::AudioBuffer<float>& input)
+        {
+            auto& buffer = buffers[(size_t) index];
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.copyFrom (channel, 0, input, channel, 0, buffer.getNumSamples());
+
+            processors[(size_t) index]->processBlock (buffer, midi[(size_t) (index % numMidiBuffers)]);
+        }
+
+        // Engines are allocated in the background once signal arrives; feeds
+        // every instance one block and waits until all of them are ready.
+        void allocate (const juce::AudioBuffer<float>& input)
+        {
+            for (int index = 0; index < size(); ++index)
+                process (index, input);
+
+            for (auto* processor : processors)
+                while (! processor->isDspAllocated())
+                    juce::Thread::sleep (1);
+        }
+
+        int size() const noexcept { return (int) processors.size(); }
+        ObsidianSpaceAudioProcessor& operator[] (int index) const noexcept { return *processors[(size_t) index]; }
+
+    private:
+        static constexpr size_t pageBytes = 4096;
+        static constexpr size_t guardBytes = 4096;
+        static constexpr size_t spacerBytes = 4096;
+        static constexpr int numMidiBuffers = 1;
+
+        const Heap heap;
+        juce::HeapBlock<char> arena;
+        std::vector<ObsidianSpaceAudioProcessor*> processors;
+        std::vector<juce::AudioBuffer<float>> buffers;
+        std::array<juce::MidiBuffer, (size_t) numMidiBuffers> midi;
+        std::vector<juce::HeapBlock<char>> spacers;
+    };
+
+    //==============================================================================
+    // Workers spin between cycles, as host audio threads do, and take
+    // instances from a shared counter. The calling thread takes part too.
+    class WorkerPool
+    {
+    public:
+        explicit WorkerPool (int numThreads)
+        {
+            for (int i = 1; i < numThreads; ++i)
+            {
+                workers.push_back (std::make_unique<Worker> (*this, i));
+                workers.back()->startRealtimeThread (juce::Thread::RealtimeOptions{});
+            }
+        }
+
+        ~WorkerPool()
+        {
+            for (auto& worker : workers)
+                worker->signalThreadShouldExit();
+
+            generation.fetch_add (1, std::memory_order_release);
+
+            for (auto& worker : workers)
+                worker->stopThread (2000);
+        }
+
+        void runCycle (InstanceSet& instances, const juce::AudioBuffer<float>& input)
+        {
+            current = &instances;
+            currentInput = &input;
+            nextInstance.store (0, std::memory_order_relaxed);
+            finishedWorkers.store (0, std::memory_order_relaxed);
+            generation.fetch_add (1, std::memory_order_release);
+
+            work();
+
+            while (finishedWorkers.load (std::memory_order_acquire) < (int) workers.size())
+                juce::Thread::yield();
+        }
+
+    private:
+        class Worker : public juce::Thread
+        {
+        public:
+            Worker (WorkerPool& ownerPool, int index)
+                : juce::Thread ("Stress worker " + juce::String (index)), pool (ownerPool) {}
+
+            void run() override
+            {
+                auto seen = pool.generation.load (std::memory_order_acquire);
+
+                while (! threadShouldExit())
+                {
+                    const auto latest = pool.generation.load (std::memory_order_acquire);
+
+                    if (latest == seen)
+                    {
+                        juce::Thread::yield();
+                        continue;
+                    }
+
+                    seen = latest;
+
+                    if (threadShouldExit())
+                        break;
+
+                    pool.work();
+                    pool.finishedWorkers.fetch_add (1, std::memory_order_release);
+                }
+            }
+
+        private:
+            WorkerPool& pool;
+        };
+
+        void work()
+        {
+            const auto count = current->size();
+
+            for (auto index = nextInstance.fetch_add (1, std::memory_order_relaxed); index < count;
+                 index = nextInstance.fetch_add (1, std::memory_order_relaxed))
+                current->process (index, *currentInput);
+        }
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        InstanceSet* current = nullptr;
+        const juce::AudioBuffer<float>* currentInput = nullptr;
+
+        alignas (64) std::atomic<juce::uint32> generation { 0 };
+        alignas (64) std::atomic<int> nextInstance { 0 };
+        alignas (64) std::atomic<int> finishedWorkers { 0 };
+    };
+
+    //==============================================================================
+    struct Measurement
+    {
+        double wallSeconds = 0.0;
+        int cycles = 0;
+        int blockSize = 0;
+        int numInstances = 0;
+
+        double getAudioSeconds() const { return (double) cycles * blockSize / sampleRate; }
+
+        // Wall time per cycle as a fraction of the block's duration.
+        double getLoad() const { return wallSeconds / getAudioSeconds(); }
+
+        double getInstanceBlocksPerSecond() const { return (double) cycles * numInstances / wallSeconds; }
+    };
+
+    // Polls what the editor polls, for every instance, until stopped.
+    class MeterReader : public juce::Thread
+    {
+    public:
+        explicit MeterReader (InstanceSet& instancesToRead)
+            : juce::Thread ("Stress meter reader"), instances (instancesToRead) {}
+
+        void run() override
+        {
+            while (! threadShouldExit())
+                for (int i = 0; i < instances.size(); ++i)
+                    sink += instances[i].getLoadMeter().getSnapshot().averageLoad
+                          + (instances[i].getWetSignalFifo().isActive() ? 1.0f : 0.0f);
+        }
+
+        float sink = 0.0f;
+
+    private:
+        InstanceSet& instances;
+    };
+
+    class StressTest
+    {
+    public:
+        StressTest (int maxInstancesToUse, int maxThreadsToUse, int blockSizeToUse, double secondsPerRun)
+            : maxInstances (maxInstancesToUse), maxThreads (maxThreadsToUse),
+              blockSize (blockSizeToUse), seconds (secondsPerRun)
+        {
+            input.setSize (2, blockSize);
+            juce::Random random (42);
+
+            for (int channel = 0; channel < input.getNumChannels(); ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    input.setSample (channel, i, (random.nextFloat() * 2.0f - 1.0f) * 0.25f);
+        }
+
+        void reportMemory()
+        {
+            const auto numInstances = juce::jmin (64, maxInstances);
+            const auto before = getResidentBytes();
+
+            InstanceSet instances (numInstances, InstanceSet::Layout::padded, InstanceSet::Heap::lazy, blockSize);
+            const auto constructed = getResidentBytes();
+
+            instances.prepare (blockSize);
+            const auto prepared = getResidentBytes();
+
+            instances.allocate (input);
+            const auto allocated = getResidentBytes();
+
+            std::cout << "\nMemory (" << numInstances << " instances)\n"
+                      << "  sizeof processor            " << formatBytes ((double) sizeof (ObsidianSpaceAudioProcessor)) << "\n"
+                      << "  resident after construction " << formatBytes ((double) (constructed - before) / numInstances) << " per instance\n"
+                      << "  resident after prepare      " << formatBytes ((double) (prepared - before) / numInstances) << " per instance\n"
+                      << "  resident after first audio  " << formatBytes ((double) (allocated - before) / numInstances) << " per instance\n";
+        }
+
+        void reportInstanceScaling()
+        {
+            std::cout << "\nInstance scaling (" << maxThreads << " threads, " << blockSize << " samples per block)\n"
+                      << juce::String::formatted ("  %9s %14s %12s\n", "instances", "us per block", "DSP load");
+
+            for (int numInstances = 1; numInstances <= maxInstances; numInstances *= 2)
+            {
+                const auto result = measure (numInstances, maxThreads, InstanceSet::Layout::padded, InstanceSet::Heap::lazy, false);
+                std::cout << juce::String::formatted ("  %9d %14.2f %11.1f%%%s\n", numInstances,
+                                                      1.0e6 * maxThreads / result.getInstanceBlocksPerSecond(),
+                                                      result.getLoad() * 100.0,
+                                                      result.getLoad() > 1.0 ? "  over budget" : "");
+            }
+        }
+
+        void reportThreadScaling()
+        {
+            const auto numInstances = juce::jmin (maxInstances, 64);
+            std::cout << "\nThread scaling (" << numInstances << " instances)\n"
+                      << juce::String::formatted ("  %7s %20s %9s %11s\n", "threads", "blocks per second", "speedup", "efficiency");
+
+            double singleThreaded = 0.0;
+
+            for (int threads = 1; threads <= maxThreads; threads = threads < maxThreads ? juce::jmin (threads * 2, maxThreads) : threads + 1)
+            {
+                const auto throughput = measure (numInstances, threads, InstanceSet::Layout::padded, InstanceSet::Heap::lazy, false).getInstanceBlocksPerSecond();
+
+                if (threads == 1)
+                    singleThreaded = throughput;
+
+                const auto speedup = throughput / singleThreaded;
+                std::cout << juce::String::formatted ("  %7d %20.0f %8.2fx %10.1f%%\n", threads, throughput, speedup,
+                                                      100.0 * speedup / threads);
+            }
+        }
+
+        void reportFalseSharing()
+        {
+            const auto numInstances = juce::jmin (maxInstances, juce::jmax (2, maxThreads * 4));
+            using Layout = InstanceSet::Layout;
+            using Heap = InstanceSet::Heap;
+
+            const auto padded = measure (numInstances, maxThreads, Layout::padded, Heap::lazy, false).getInstanceBlocksPerSecond();
+            const auto packed = measure (numInstances, maxThreads, Layout::packed, Heap::lazy, false).getInstanceBlocksPerSecond();
+            const auto adjacentHeap = measure (numInstances, maxThreads, Layout::padded, Heap::adjacent, false).getInstanceBlocksPerSecond();
+            const auto separatedHeap = measure (numInstances, maxThreads, Layout::padded, Heap::separated, false).getInstanceBlocksPerSecond();
+            const auto withReader = measure (numInstances, maxThreads, Layout::padded, Heap::lazy, true).getInstanceBlocksPerSecond();
+
+            auto describe = [] (double ratio)
+            {
+                return juce::String::formatted ("%+.1f%%", (ratio - 1.0) * 100.0) + (ratio < 1.0 - threshold ? "  suspect" : "");
+            };
+
+            std::cout << "\nFalse sharing (" << numInstances << " instances, " << maxThreads << " threads)\n"
+                      << "  packed vs padded instances    " << describe (packed / padded) << "\n"
+                      << "  adjacent vs separated heap    " << describe (adjacentHeap / separatedHeap) << "\n"
+                      << "  with vs without meter reader  " << describe (withReader / padded) << "\n";
+        }
+
+    private:
+        Measurement measure (int numInstances, int numThreads, InstanceSet::Layout layout,
+                             InstanceSet::Heap heap, bool withMeterReader)
+        {
+            InstanceSet instances (numInstances, layout, heap, blockSize);
+            instances.prepare (blockSize);
+            instances.allocate (input);
+
+            WorkerPool pool (numThreads);
+            MeterReader reader (instances);
+
+            if (withMeterReader)
+                reader.startThread();
+
+            Measurement result;
+            result.blockSize = blockSize;
+            result.numInstances = numInstances;
+            result.cycles = juce::jmax (1, juce::roundToInt (seconds * sampleRate / blockSize));
+
+            // Warm caches and let the tails build up before timing.
+            for (int cycle = 0; cycle < juce::jmin (32, result.cycles); ++cycle)
+                pool.runCycle (instances, input);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+
+            for (int cycle = 0; cycle < result.cycles; ++cycle)
+                pool.runCycle (instances, input);
+
+            result.wallSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+
+            reader.stopThread (1000);
+            return result;
+        }
+
+        static constexpr double threshold = 0.05;
+
+        const int maxInstances;
+        const int maxThreads;
+        const int blockSize;
+        const double seconds;
+        juce::AudioBuffer<float> input;
+    };
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    auto option = [&args] (const juce::String& name, const juce::String& fallback)
+    {
+        return args.containsOption (name) ? args.getValueForOption (name) : fallback;
+    };
+
+    const auto maxInstances = juce::jlimit (1, 512, option ("--max-instances", "512").getIntValue());
+    const auto maxThreads = juce::jmax (1, option ("--threads", juce::String (juce::SystemStats::getNumPhysicalCpus())).getIntValue());
+    const auto blockSize = juce::jlimit (16, 8192, option ("--block-size", "256").getIntValue());
+    const auto seconds = juce::jmax (0.1, option ("--seconds", "1.0").getDoubleValue());
+
+    std::cout << "Obsidian Space instance stress test: up to " << maxInstances << " instances, "
+              << maxThreads << " threads, " << blockSize << " samples at " << sampleRate << " Hz, "
+              << seconds << " s of audio per run\n";
+
+    StressTest test (maxInstances, maxThreads, blockSize, seconds);
+    test.reportMemory();
+    test.reportInstanceScaling();
+    test.reportThreadScaling();
+    test.reportFalseSharing();
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    Kernel test for the Obsidian Space reverb network.
+
+    Runs every kernel variant this machine supports against the scalar one on
+    random data, and exits with a non-zero status if any output, filter state
+    or spectral bin drifts past a small tolerance. Run it on each CPU the
+    build targets. The checks live here rather than in DspKernels, so none of
+    this ships in the plugin.
+
+    Usage: KernelTest
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/DspKernels.h"
+
+namespace
+{
+    using namespace DspKernels;
+
+    bool isClose (const float* a, const float* b, int numSamples, float tolerance) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            if (std::abs (a[i] - b[i]) > tolerance * juce::jmax (1.0f, std::abs (a[i])))
+                return false;
+
+        return true;
+    }
+
+    void fillRandom (juce::Random& random, float* destination, int numSamples, float minimum, float maximum) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            destination[i] = juce::jmap (random.nextFloat(), minimum, maximum);
+    }
+
+    bool combsAgree (const Kernels& reference, const Kernels& candidate, int numChannels, int combsPerChannel, juce::Random& random)
+    {
+        constexpr int numSamples = 1024;
+        std::vector<float> input (numSamples), damping (numSamples), feedback (numSamples);
+        fillRandom (random, input.data(), numSamples, -1.0f, 1.0f);
+        fillRandom (random, damping.data(), numSamples, 0.0f, 0.4f);
+        fillRandom (random, feedback.data(), numSamples, 0.7f, 0.98f);
+
+        CombBank bank;
+        int total = 0;
+
+        for (int lane = 0; lane < CombBank::numLanes; ++lane)
+        {
+            bank.offsets[(size_t) lane] = total;
+            bank.sizes[(size_t) lane] = 200 + random.nextInt (400);
+            bank.indices[(size_t) lane] = random.nextInt (bank.sizes[(size_t) lane]);
+            bank.last[(size_t) lane] = random.nextFloat() - 0.5f;
+            total += bank.sizes[(size_t) lane];
+        }
+
+        std::vector<float> referenceMemory ((size_t) total), candidateMemory;
+        fillRandom (random, referenceMemory.data(), total, -0.5f, 0.5f);
+        candidateMemory = referenceMemory;
+
+        auto referenceBank = bank, candidateBank = bank;
+        referenceBank.memory = referenceMemory.data();
+        candidateBank.memory = candidateMemory.data();
+
+        const auto variant = (size_t) getCombVariant (numChannels, combsPerChannel);
+        std::vector<float> referenceOut (2 * numSamples), candidateOut (2 * numSamples);
+        reference.processCombs[variant] (referenceBank, input.data(), damping.data(), feedback.data(),
+                                         referenceOut.data(), referenceOut.data() + numSamples, numSamples);
+        candidate.processCombs[variant] (candidateBank, input.data(), damping.data(), feedback.data(),
+                                         candidateOut.data(), candidateOut.data() + numSamples, numSamples);
+
+        // Lanes outside the network must be left untouched by both.
+        constexpr auto tolerance = 1.0e-4f;
+
+        return isClose (referenceOut.data(), candidateOut.data(), numChannels * numSamples, tolerance)
+            && isClose (referenceMemory.data(), candidateMemory.data(), total, tolerance)
+            && isClose (referenceBank.last.data(), candidateBank.last.data(), CombBank::numLanes, tolerance)
+            && referenceBank.indices == candidateBank.indices;
+    }
+
+    bool mixingAgrees (const Kernels& reference, const Kernels& candidate, juce::Random& random)
+    {
+        // An odd length exercises the scalar tails too.
+        constexpr int numSamples = 1021;
+        juce::AudioBuffer<float> sources (5, numSamples), referenceOut (3, numSamples), candidateOut (3, numSamples);
+
+        for (int channel = 0; channel < sources.getNumChannels(); ++channel)
+            fillRandom (random, sources.getWritePointer (channel), numSamples, -1.0f, 1.0f);
+
+        for (int channel = 0; channel < referenceOut.getNumChannels(); ++channel)
+            fillRandom (random, referenceOut.getWritePointer (channel), numSamples, -1.0f, 1.0f);
+
+        candidateOut.makeCopyOf (referenceOut);
+
+        for (auto* out : { &referenceOut, &candidateOut })
+        {
+            const auto& kernels = out == &referenceOut ? reference : candidate;
+            kernels.mixStereo (out->getWritePointer (0), out->getWritePointer (1), sources.getReadPointer (0), sources.getReadPointer (1),
+                               sources.getReadPointer (2), sources.getReadPointer (3), sources.getReadPointer (4), numSamples);
+            kernels.addWithGains (out->getWritePointer (2), sources.getReadPointer (0), sources.getReadPointer (4), numSamples);
+        }
+
+        for (int channel = 0; channel < referenceOut.getNumChannels(); ++channel)
+            if (! isClose (referenceOut.getReadPointer (channel), candidateOut.getReadPointer (channel), numSamples, 1.0e-5f))
+                return false;
+
+        return true;
+    }
+
+    bool binsAgree (const Kernels& reference, const Kernels& candidate, juce::Random& random)
+    {
+        // An odd count, like a real spectrum's, exercises the scalar tails.
+        constexpr int numBins = 1025;
+        std::vector<float> referenceSpectrum (2 * numBins), energyDecay (numBins), inputGain (numBins);
+        std::vector<float> referenceEnergy (numBins);
+        std::vector<juce::uint32> referenceSeeds (numBins);
+        fillRandom (random, referenceSpectrum.data(), 2 * numBins, -10.0f, 10.0f);
+        fillRandom (random, referenceEnergy.data(), numBins, 0.0f, 100.0f);
+        fillRandom (random, energyDecay.data(), numBins, 0.5f, 1.0f);
+
+        for (int bin = 0; bin < numBins; ++bin)
+        {
+            inputGain[(size_t) bin] = 1.0f - energyDecay[(size_t) bin];
+            referenceSeeds[(size_t) bin] = (juce::uint32) random.nextInt() | 1u;
+        }
+
+        auto candidateSpectrum = referenceSpectrum;
+        auto candidateEnergy = referenceEnergy;
+        auto candidateSeeds = referenceSeeds;
+
+        reference.resynthesiseBins (referenceSpectrum.data(), referenceEnergy.data(), referenceSeeds.data(),
+                                    energyDecay.data(), inputGain.data(), numBins);
+        candidate.resynthesiseBins (candidateSpectrum.data(), candidateEnergy.data(), candidateSeeds.data(),
+                                    energyDecay.data(), inputGain.data(), numBins);
+
+        return isClose (referenceSpectrum.data(), candidateSpectrum.data(), 2 * numBins, 1.0e-5f)
+            && isClose (referenceEnergy.data(), candidateEnergy.data(), numBins, 1.0e-5f)
+            && referenceSeeds == candidateSeeds;
+    }
+
+    // Runs every variant this machine supports against the scalar one on
+    // random data; false if any output or state drifts past a small tolerance.
+    bool variantsAgree()
+    {
+        juce::Random random (0x0b5d);
+        const auto& reference = getKernels (InstructionSet::scalar);
+
+        for (auto instructionSet : { InstructionSet::sse2, InstructionSet::avx2, InstructionSet::avx512 })
+        {
+            if (instructionSet > detectInstructionSet())
+                break;
+
+            const auto& candidate = getKernels (instructionSet);
+
+            for (auto numChannels : { 1, 2 })
+                for (auto combsPerChannel : { 4, CombBank::lanesPerChannel })
+                    if (! combsAgree (reference, candidate, numChannels, combsPerChannel, random))
+                        return false;
+
+            if (! mixingAgrees (reference, candidate, random) || ! binsAgree (reference, candidate, random))
+                return false;
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    const auto detected = DspKernels::detectInstructionSet();
+    std::cout << "Obsidian Space kernel test: this machine runs up to "
+              << DspKernels::getName (detected) << '\n';
+
+    if (! variantsAgree())
+    {
+        std::cout << "FAILED: a kernel variant does not match the scalar one\n";
+        return 1;
+    }
+
+    std::cout << "Every supported variant matches the scalar one\n";
+    return 0;
+}
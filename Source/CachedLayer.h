@@ -0,0 +1,44 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// An image of static artwork, rendered on first use at the physical pixel
+// scale it is drawn at and reused until its size or the scale changes, or it
+// is invalidated. The render function draws with the layer's top-left at (0, 0).
+class CachedLayer
+{
+public:
+    void invalidate() noexcept { image = {}; }
+
+    template <typename RenderFunction>
+    void draw (juce::Graphics& g, juce::Rectangle<int> area, RenderFunction&& render)
+    {
+        if (area.isEmpty())
+            return;
+
+        const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+        if (! image.isValid() || scale != imageScale || area.getWidth() != logicalWidth || area.getHeight() != logicalHeight)
+        {
+            imageScale = scale;
+            logicalWidth = area.getWidth();
+            logicalHeight = area.getHeight();
+            image = juce::Image (juce::Image::ARGB,
+                                 juce::jmax (1, juce::roundToInt ((float) logicalWidth * scale)),
+                                 juce::jmax (1, juce::roundToInt ((float) logicalHeight * scale)),
+                                 true);
+
+            juce::Graphics imageGraphics (image);
+            imageGraphics.addTransform (juce::AffineTransform::scale (scale));
+            render (imageGraphics);
+        }
+
+        g.drawImage (image, area.toFloat());
+    }
+
+private:
+    juce::Image image;
+    float imageScale = 0.0f;
+    int logicalWidth = 0;
+    int logicalHeight = 0;
+};
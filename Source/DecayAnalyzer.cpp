@@ -0,0 +1,154 @@
+#include "DecayAnalyzer.h"
+
+DecayAnalyzer::DecayAnalyzer()
+{
+    const auto maximumSize = (size_t) 1 << maximumOrder;
+    mono.resize (maximumSize);
+    spectrum.resize (maximumSize * 2);
+    bandBuffer.resize (maximumSize * 2);
+    decayCurve.resize (maximumSize);
+}
+
+juce::dsp::FFT& DecayAnalyzer::getFFT (int order)
+{
+    auto& fft = ffts[(size_t) order];
+
+    if (fft == nullptr)
+        fft = std::make_unique<juce::dsp::FFT> (order);
+
+    return *fft;
+}
+
+void DecayAnalyzer::analyse (const juce::AudioBuffer<float>& samples, int numSamplesToUse, double sampleRate,
+                             const std::function<bool()>& shouldStop,
+                             const std::function<void (const DecayAnalysis&)>& onProgress)
+{
+    const auto numSamples = juce::jmin (numSamplesToUse, samples.getNumSamples(), 1 << maximumOrder);
+    if (numSamples < 64)
+        return;
+
+    int order = minimumOrder;
+    while ((1 << order) < numSamples)
+        ++order;
+
+    const auto size = 1 << order;
+    const auto numChannels = juce::jmin (2, samples.getNumChannels());
+
+    std::fill (mono.begin(), mono.begin() + size, 0.0f);
+    for (int channel = 0; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::addWithMultiply (mono.data(), samples.getReadPointer (channel),
+                                                      1.0f / (float) numChannels, numSamples);
+
+    DecayAnalysis analysis;
+    analysis.durationSeconds = (double) numSamples / sampleRate;
+
+    computeDecayCurve (mono.data(), numSamples);
+    analysis.broadbandRt60 = estimateRt60 (decayCurve, sampleRate, numSamples);
+
+    analysis.decayCurveDb.resize ((size_t) DecayAnalysis::numCurvePoints);
+    for (int point = 0; point < DecayAnalysis::numCurvePoints; ++point)
+    {
+        auto index = (int) ((juce::int64) (numSamples - 1) * point / (DecayAnalysis::numCurvePoints - 1));
+        analysis.decayCurveDb[(size_t) point] = (float) decayCurve[(size_t) index];
+    }
+
+    onProgress (analysis);
+
+    if (shouldStop())
+        return;
+
+    // Octave bands are cut from one forward transform of the whole response
+    // with cos^2 windows in log frequency, which sum to one between bands.
+    auto& fft = getFFT (order);
+    std::copy (mono.begin(), mono.begin() + size, spectrum.begin());
+    std::fill (spectrum.begin() + size, spectrum.begin() + size * 2, 0.0f);
+    fft.performRealOnlyForwardTransform (spectrum.data(), true);
+
+    const auto binWidth = sampleRate / (double) size;
+    const auto numBins = size / 2 + 1;
+
+    for (int band = 0; band < DecayAnalysis::numBands; ++band)
+    {
+        const auto centre = (double) DecayAnalysis::bandCentres[(size_t) band];
+        std::fill (bandBuffer.begin(), bandBuffer.begin() + size * 2, 0.0f);
+
+        for (int bin = 1; bin < numBins; ++bin)
+        {
+            const auto distance = std::log2 ((double) bin * binWidth / centre);
+            if (std::abs (distance) >= 1.0)
+                continue;
+
+            const auto weight = (float) juce::square (std::cos (juce::MathConstants<double>::halfPi * distance));
+            bandBuffer[(size_t) bin * 2] = spectrum[(size_t) bin * 2] * weight;
+            bandBuffer[(size_t) bin * 2 + 1] = spectrum[(size_t) bin * 2 + 1] * weight;
+        }
+
+        fft.performRealOnlyInverseTransform (bandBuffer.data());
+
+        if (shouldStop())
+            return;
+
+        computeDecayCurve (bandBuffer.data(), numSamples);
+        analysis.bandRt60[(size_t) band] = estimateRt60 (decayCurve, sampleRate, numSamples);
+        analysis.numBandsAnalysed = band + 1;
+        onProgress (analysis);
+    }
+}
+
+void DecayAnalyzer::computeDecayCurve (const float* signal, int numSamples)
+{
+    // Schroeder backward integration of the squared response.
+    double energy = 0.0;
+    for (int i = numSamples; --i >= 0;)
+    {
+        energy += (double) signal[i] * (double) signal[i];
+        decayCurve[(size_t) i] = energy;
+    }
+
+    const auto total = juce::jmax (decayCurve[0], 1.0e-30);
+    for (int i = 0; i < numSamples; ++i)
+        decayCurve[(size_t) i] = 10.0 * std::log10 (juce::jmax (decayCurve[(size_t) i], 1.0e-30) / total);
+}
+
+float DecayAnalyzer::estimateRt60 (const std::vector<double>& curveDb, double sampleRate, int numSamples)
+{
+    // T20 where the curve gets that far, otherwise T10, extrapolated to 60 dB.
+    auto findIndex = [&] (double levelDb, int from)
+    {
+        for (int i = from; i < numSamples; ++i)
+            if (curveDb[(size_t) i] <= levelDb)
+                return i;
+        return -1;
+    };
+
+    const auto start = findIndex (-5.0, 0);
+    if (start < 0)
+        return 0.0f;
+
+    auto end = findIndex (-25.0, start);
+    if (end < 0)
+        end = findIndex (-15.0, start);
+    if (end < 0 || end - start < 8)
+        return 0.0f;
+
+    // Least-squares slope of level against time over [start, end].
+    const auto count = (double) (end - start + 1);
+    double sumT = 0.0, sumL = 0.0, sumTT = 0.0, sumTL = 0.0;
+
+    for (int i = start; i <= end; ++i)
+    {
+        const auto t = (double) i / sampleRate;
+        const auto level = curveDb[(size_t) i];
+        sumT += t;
+        sumL += level;
+        sumTT += t * t;
+        sumTL += t * level;
+    }
+
+    const auto denominator = count * sumTT - sumT * sumT;
+    if (denominator <= 0.0)
+        return 0.0f;
+
+    const auto slope = (count * sumTL - sumT * sumL) / denominator;
+    return slope < 0.0 ? (float) (-60.0 / slope) : 0.0f;
+}
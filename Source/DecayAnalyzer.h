@@ -0,0 +1,52 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Schroeder energy decay and RT60 of one rendered impulse response.
+struct DecayAnalysis
+{
+    static constexpr int numBands = 7;
+    static constexpr std::array<float, (size_t) numBands> bandCentres { 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f };
+    static constexpr int numCurvePoints = 256;
+
+    double durationSeconds = 0.0;
+
+    // Broadband energy decay curve in dB relative to the total energy,
+    // sampled at numCurvePoints evenly spaced times over the response.
+    std::vector<float> decayCurveDb;
+    float broadbandRt60 = 0.0f;
+
+    // Per-octave RT60 in seconds; zero where the band has not been analysed
+    // yet or decays too little to estimate.
+    std::array<float, (size_t) numBands> bandRt60 {};
+    int numBandsAnalysed = 0;
+};
+
+// Analyses impulse responses for the renderer thread, with buffers allocated
+// once for the longest supported response. The broadband curve comes first
+// and then each octave band, so the view can fill in progressively.
+class DecayAnalyzer
+{
+public:
+    DecayAnalyzer();
+
+    // Calls onProgress after the broadband curve and after each band, and
+    // gives up between steps once shouldStop returns true.
+    void analyse (const juce::AudioBuffer<float>& samples, int numSamples, double sampleRate,
+                  const std::function<bool()>& shouldStop,
+                  const std::function<void (const DecayAnalysis&)>& onProgress);
+
+private:
+    juce::dsp::FFT& getFFT (int order);
+    void computeDecayCurve (const float* signal, int numSamples);
+    static float estimateRt60 (const std::vector<double>& curveDb, double sampleRate, int numSamples);
+
+    static constexpr int minimumOrder = 10;
+    static constexpr int maximumOrder = 19;
+
+    std::array<std::unique_ptr<juce::dsp::FFT>, (size_t) maximumOrder + 1> ffts;
+    std::vector<float> mono, spectrum, bandBuffer;
+    std::vector<double> decayCurve;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DecayAnalyzer)
+};
@@ -0,0 +1,142 @@
+#include "DecayAnalyzerComponent.h"
+
+DecayAnalyzerComponent::DecayAnalyzerComponent (ImpulseResponseRenderer::Client& impulseResponses)
+    : renderer (impulseResponses)
+{
+    renderer.addChangeListener (this);
+    changeListenerCallback (&renderer);
+}
+
+DecayAnalyzerComponent::~DecayAnalyzerComponent()
+{
+    renderer.removeChangeListener (this);
+}
+
+void DecayAnalyzerComponent::changeListenerCallback (juce::ChangeBroadcaster* source)
+{
+    juce::ignoreUnused (source);
+
+    if (auto result = renderer.getLatestResult())
+        analysis = std::shared_ptr<const DecayAnalysis> (result, &result->decay);
+    else
+        analysis.reset();
+
+    updateCurvePath();
+    repaint();
+}
+
+void DecayAnalyzerComponent::resized()
+{
+    auto bounds = getLocalBounds().toFloat().reduced (16.0f, 12.0f);
+    bounds.removeFromTop (20.0f);
+    bandArea = bounds.removeFromBottom (juce::jmin (96.0f, bounds.getHeight() * 0.45f));
+    bounds.removeFromBottom (10.0f);
+    curveArea = bounds;
+
+    updateCurvePath();
+}
+
+void DecayAnalyzerComponent::updateCurvePath()
+{
+    curvePath.clear();
+
+    if (analysis == nullptr || analysis->decayCurveDb.empty())
+        return;
+
+    const auto& curve = analysis->decayCurveDb;
+    const auto numPoints = (int) curve.size();
+
+    for (int point = 0; point < numPoints; ++point)
+    {
+        auto x = curveArea.getX() + curveArea.getWidth() * (float) point / (float) (numPoints - 1);
+        auto db = juce::jlimit (floorDb, 0.0f, curve[(size_t) point]);
+        auto y = juce::jmap (db, 0.0f, floorDb, curveArea.getY(), curveArea.getBottom());
+
+        if (point == 0)
+            curvePath.startNewSubPath (x, y);
+        else
+            curvePath.lineTo (x, y);
+    }
+}
+
+juce::String DecayAnalyzerComponent::formatSeconds (float seconds)
+{
+    if (seconds <= 0.0f)
+        return "--";
+    return juce::String (seconds, seconds < 10.0f ? 2 : 1) + "s";
+}
+
+void DecayAnalyzerComponent::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    const float radius = 12.0f;
+
+    g.setColour (ObsidianStyle::panelFillDark());
+    g.fillRoundedRectangle (bounds, radius);
+    g.setColour (ObsidianStyle::borderPurple());
+    g.drawRoundedRectangle (bounds, radius, 1.0f);
+
+    auto titleArea = bounds.reduced (16.0f, 12.0f).removeFromTop (16.0f);
+    g.setFont (juce::Font (12.0f, juce::Font::plain));
+    g.setColour (ObsidianStyle::textSecondary().withAlpha (0.85f));
+    g.drawText ("ENERGY DECAY", titleArea, juce::Justification::centredLeft);
+
+    g.setColour (ObsidianStyle::textPrimary());
+    g.drawText ("RT60 " + formatSeconds (analysis != nullptr ? analysis->broadbandRt60 : 0.0f),
+                titleArea, juce::Justification::centredRight);
+
+    // Energy decay curve against a 10 dB grid.
+    g.setColour (ObsidianStyle::accentPurple().withAlpha (0.12f));
+    for (int db = 0; db >= (int) floorDb; db -= 10)
+    {
+        auto y = juce::jmap ((float) db, 0.0f, floorDb, curveArea.getY(), curveArea.getBottom());
+        g.drawHorizontalLine (juce::roundToInt (y), curveArea.getX(), curveArea.getRight());
+    }
+
+    g.setColour (ObsidianStyle::accentLight().withAlpha (0.9f));
+    g.strokePath (curvePath, juce::PathStrokeType (1.6f));
+
+    if (analysis != nullptr && analysis->durationSeconds > 0.0)
+    {
+        g.setFont (juce::Font (10.5f, juce::Font::plain));
+        g.setColour (ObsidianStyle::textSecondary().withAlpha (0.6f));
+        g.drawText (formatSeconds ((float) analysis->durationSeconds),
+                    curveArea.withTrimmedTop (curveArea.getHeight() - 14.0f), juce::Justification::bottomRight);
+    }
+
+    // Per-octave RT60 bars, scaled to the longest band.
+    float longest = 0.0f;
+    if (analysis != nullptr)
+        for (auto rt60 : analysis->bandRt60)
+            longest = juce::jmax (longest, rt60);
+
+    const auto bandWidth = bandArea.getWidth() / (float) DecayAnalysis::numBands;
+    const auto labelHeight = 14.0f;
+    g.setFont (juce::Font (10.5f, juce::Font::plain));
+
+    for (int band = 0; band < DecayAnalysis::numBands; ++band)
+    {
+        auto column = juce::Rectangle<float> (bandArea.getX() + bandWidth * (float) band, bandArea.getY(),
+                                              bandWidth, bandArea.getHeight()).reduced (3.0f, 0.0f);
+        auto centre = DecayAnalysis::bandCentres[(size_t) band];
+        auto label = centre >= 1000.0f ? juce::String (juce::roundToInt (centre / 1000.0f)) + "k"
+                                       : juce::String (juce::roundToInt (centre));
+
+        g.setColour (ObsidianStyle::textSecondary().withAlpha (0.7f));
+        g.drawText (label, column.removeFromBottom (labelHeight), juce::Justification::centred);
+
+        const bool isAnalysed = analysis != nullptr && band < analysis->numBandsAnalysed;
+        const auto rt60 = isAnalysed ? analysis->bandRt60[(size_t) band] : 0.0f;
+
+        g.setColour (ObsidianStyle::textPrimary().withAlpha (isAnalysed ? 0.9f : 0.4f));
+        g.drawText (isAnalysed ? formatSeconds (rt60) : "...", column.removeFromTop (labelHeight),
+                    juce::Justification::centred);
+
+        if (longest > 0.0f && rt60 > 0.0f)
+        {
+            auto bar = column.withTrimmedTop (column.getHeight() * (1.0f - rt60 / longest));
+            g.setColour (ObsidianStyle::accentViolet().withAlpha (0.6f));
+            g.fillRoundedRectangle (bar.reduced (4.0f, 0.0f), 3.0f);
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ObsidianSpaceLookAndFeel.h"
+#include "ImpulseResponseRenderer.h"
+
+class DecayAnalyzerComponent : public juce::Component,
+                               private juce::ChangeListener
+{
+public:
+    explicit DecayAnalyzerComponent (ImpulseResponseRenderer::Client& impulseResponses);
+    ~DecayAnalyzerComponent() override;
+
+    void paint (juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    void changeListenerCallback (juce::ChangeBroadcaster* source) override;
+    void updateCurvePath();
+    static juce::String formatSeconds (float seconds);
+
+    ImpulseResponseRenderer::Client& renderer;
+    std::shared_ptr<const DecayAnalysis> analysis;
+
+    juce::Rectangle<float> curveArea, bandArea;
+    juce::Path curvePath;
+
+    static constexpr float floorDb = -60.0f;
+};
@@ -0,0 +1,119 @@
+#include "DspAllocator.h"
+
+void DspAllocator::Client::allocateNow()
+{
+    allocate();
+    state.store (State::allocated, std::memory_order_release);
+}
+
+void DspAllocator::Client::allocateNowOrWait()
+{
+    for (auto from : { State::unallocated, State::requested })
+    {
+        auto expected = from;
+
+        if (state.compare_exchange_strong (expected, State::allocating, std::memory_order_acquire))
+        {
+            allocate();
+            state.store (State::allocated, std::memory_order_release);
+            allocationFinished();
+            return;
+        }
+    }
+
+    while (! isAllocated())
+        juce::Thread::sleep (1);
+}
+
+//==============================================================================
+DspAllocator::DspAllocator()
+    : juce::Thread ("Obsidian Space DSP Allocator")
+{
+    startThread (juce::Thread::Priority::low);
+}
+
+DspAllocator::~DspAllocator()
+{
+    stopThread (2000);
+}
+
+void DspAllocator::add (Client& client)
+{
+    if (client.isAllocated())
+        return;
+
+    {
+        const juce::ScopedLock sl (lock);
+        clients.addIfNotAlreadyThere (&client);
+    }
+
+    notify();
+}
+
+void DspAllocator::remove (Client& client)
+{
+    for (;;)
+    {
+        {
+            const juce::ScopedLock sl (lock);
+            clients.removeAllInstancesOf (&client);
+
+            if (allocating != &client)
+                return;
+        }
+
+        allocationDone.wait (10);
+    }
+}
+
+void DspAllocator::run()
+{
+    while (! threadShouldExit())
+    {
+        Client* client = nullptr;
+        bool isWatching = false;
+
+        {
+            const juce::ScopedLock sl (lock);
+
+            // Clients that allocated on their own thread need no watching.
+            clients.removeIf ([] (Client* candidate) { return candidate->isAllocated(); });
+
+            for (auto* candidate : clients)
+            {
+                auto expected = Client::State::requested;
+
+                if (candidate->state.compare_exchange_strong (expected, Client::State::allocating, std::memory_order_relaxed))
+                {
+                    client = candidate;
+                    break;
+                }
+            }
+
+            if (client != nullptr)
+            {
+                clients.removeFirstMatchingValue (client);
+                allocating = client;
+            }
+
+            isWatching = ! clients.isEmpty();
+        }
+
+        if (client == nullptr)
+        {
+            wait (isWatching ? pollIntervalMs : -1);
+            continue;
+        }
+
+        client->allocate();
+        client->state.store (Client::State::allocated, std::memory_order_release);
+        client->allocationFinished();
+
+        {
+            const juce::ScopedLock sl (lock);
+            allocating = nullptr;
+        }
+
+        allocationDone.signal();
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// One low-priority thread per process that allocates DSP memory for
+// processors once they first see signal, so instances that stay silent
+// never hold their delay lines. The audio thread only flips an atomic to
+// ask; the thread polls the clients it is watching, since waking it from
+// the audio thread would mean taking a lock. Shared through a
+// SharedResourcePointer.
+class DspAllocator : private juce::Thread
+{
+public:
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        // Audio thread. Never blocks; allocation follows within a few
+        // milliseconds if the client is being watched.
+        void requestAllocation() noexcept
+        {
+            auto expected = State::unallocated;
+            state.compare_exchange_strong (expected, State::requested, std::memory_order_relaxed);
+        }
+
+        // Any thread. Once true, everything allocate() prepared is visible.
+        bool isAllocated() const noexcept { return state.load (std::memory_order_acquire) == State::allocated; }
+
+    protected:
+        // Message thread, with the client not being watched. Allocates on
+        // the calling thread instead, e.g. for offline rendering.
+        void allocateNow();
+
+        // Any thread that may block, such as an offline render, even while
+        // being watched. Allocates on the calling thread unless the
+        // allocator thread has already started, then waits for it.
+        void allocateNowOrWait();
+
+    private:
+        friend class DspAllocator;
+
+        // Allocator thread, or the message thread through allocateNow().
+        virtual void allocate() = 0;
+
+        // Whichever thread allocated, after isAllocated() turns true.
+        virtual void allocationFinished() {}
+
+        enum class State { unallocated, requested, allocating, allocated };
+        std::atomic<State> state { State::unallocated };
+    };
+
+    DspAllocator();
+    ~DspAllocator() override;
+
+    // Message thread. Watches the client until it asks for allocation and
+    // has been allocated.
+    void add (Client& client);
+
+    // Message thread. Stops watching, and waits for an allocation in
+    // progress, after which the client is allocated.
+    void remove (Client& client);
+
+private:
+    void run() override;
+
+    static constexpr int pollIntervalMs = 10;
+
+    juce::CriticalSection lock;
+    juce::Array<Client*> clients;
+    Client* allocating = nullptr;
+    juce::WaitableEvent allocationDone;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DspAllocator)
+};
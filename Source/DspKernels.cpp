@@ -0,0 +1,201 @@
+#include "DspKernels.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <cpuid.h>
+ #endif
+#endif
+
+namespace DspKernels
+{
+namespace
+{
+   #if JUCE_INTEL
+    std::array<unsigned int, 4> cpuid (unsigned int leaf, unsigned int subleaf) noexcept
+    {
+        std::array<unsigned int, 4> registers {};
+
+       #if JUCE_MSVC
+        int values[4];
+        __cpuidex (values, (int) leaf, (int) subleaf);
+
+        for (size_t i = 0; i < registers.size(); ++i)
+            registers[i] = (unsigned int) values[i];
+       #else
+        __cpuid_count (leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+       #endif
+
+        return registers;
+    }
+
+    // Which register files the OS saves on a context switch.
+    unsigned long long readXcr0() noexcept
+    {
+       #if JUCE_MSVC
+        return _xgetbv (0);
+       #else
+        unsigned int low, high;
+        __asm__ volatile ("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+        return ((unsigned long long) high << 32) | low;
+       #endif
+    }
+   #endif
+
+    //==============================================================================
+    // One channel at a time, sample by sample, with the lanes in fixed-size
+    // local arrays so the inner loop unrolls and the state stays in
+    // registers. Each sample's lanes are summed in comb order.
+    template <int numChannels, int combsPerChannel>
+    void processCombs (CombBank& bank, const float* input, const float* damping, const float* feedback,
+                       float* outLeft, float* outRight, int numSamples) noexcept
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto first = (size_t) (channel * CombBank::lanesPerChannel);
+            auto* out = channel == 0 ? outLeft : outRight;
+            std::array<float*, (size_t) combsPerChannel> lines;
+            std::array<int, (size_t) combsPerChannel> sizes, indices;
+            std::array<float, (size_t) combsPerChannel> last;
+
+            for (size_t j = 0; j < (size_t) combsPerChannel; ++j)
+            {
+                lines[j] = bank.memory + bank.offsets[first + j];
+                sizes[j] = bank.sizes[first + j];
+                indices[j] = bank.indices[first + j];
+                last[j] = bank.last[first + j];
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto sum = 0.0f;
+
+                for (size_t j = 0; j < (size_t) combsPerChannel; ++j)
+                {
+                    const auto output = lines[j][indices[j]];
+                    last[j] = (output * (1.0f - damping[i])) + (last[j] * damping[i]);
+                    JUCE_UNDENORMALISE (last[j]);
+
+                    auto temp = input[i] + (last[j] * feedback[i]);
+                    JUCE_UNDENORMALISE (temp);
+                    lines[j][indices[j]] = temp;
+
+                    if (++indices[j] >= sizes[j])
+                        indices[j] = 0;
+
+                    sum += output;
+                }
+
+                out[i] = sum;
+            }
+
+            for (size_t j = 0; j < (size_t) combsPerChannel; ++j)
+            {
+                bank.indices[first + j] = indices[j];
+                bank.last[first + j] = last[j];
+            }
+        }
+    }
+
+    void mixStereo (float* left, float* right, const float* wetLeft, const float* wetRight,
+                    const float* wet1, const float* wet2, const float* dry, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto l = wetLeft[i] * wet1[i] + wetRight[i] * wet2[i] + left[i] * dry[i];
+            const auto r = wetRight[i] * wet1[i] + wetLeft[i] * wet2[i] + right[i] * dry[i];
+            left[i] = l;
+            right[i] = r;
+        }
+    }
+
+    void addWithGains (float* destination, const float* source, const float* gains, int numSamples) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            destination[i] += source[i] * gains[i];
+    }
+
+    void resynthesiseBins (float* spectrum, float* energy, juce::uint32* seeds,
+                           const float* decay, const float* gain, int numBins) noexcept
+    {
+        for (int bin = 0; bin < numBins; ++bin)
+            resynthesiseBin (spectrum + 2 * bin, energy[bin], seeds[bin], decay[bin], gain[bin]);
+    }
+
+    const Kernels scalarKernels { InstructionSet::scalar,
+                                  { processCombs<1, 4>, processCombs<1, 8>, processCombs<2, 4>, processCombs<2, 8> },
+                                  mixStereo, addWithGains, resynthesiseBins };
+}
+
+//==============================================================================
+InstructionSet detectInstructionSet() noexcept
+{
+    static const auto detected = []
+    {
+       #if JUCE_INTEL
+        const auto maximumLeaf = cpuid (0, 0)[0];
+        const auto features = cpuid (1, 0);
+
+        if ((features[3] & (1u << 26)) == 0)
+            return InstructionSet::scalar;
+
+        const auto hasOsXsave = (features[2] & (1u << 27)) != 0;
+        const auto hasAvx = (features[2] & (1u << 28)) != 0;
+        const auto hasFma = (features[2] & (1u << 12)) != 0;
+
+        if (! (hasOsXsave && hasAvx && hasFma && maximumLeaf >= 7))
+            return InstructionSet::sse2;
+
+        // The CPU supporting a set is not enough; the OS must also save its
+        // registers: XMM and YMM for AVX2, plus the mask and ZMM state.
+        const auto xcr0 = readXcr0();
+        const auto extended = cpuid (7, 0);
+
+        if ((xcr0 & 0x6) != 0x6 || (extended[1] & (1u << 5)) == 0)
+            return InstructionSet::sse2;
+
+        if ((xcr0 & 0xe6) != 0xe6 || (extended[1] & (1u << 16)) == 0)
+            return InstructionSet::avx2;
+
+        return InstructionSet::avx512;
+       #else
+        return InstructionSet::scalar;
+       #endif
+    }();
+
+    return detected;
+}
+
+const char* getName (InstructionSet instructionSet) noexcept
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::sse2:    return "SSE2";
+        case InstructionSet::avx2:    return "AVX2";
+        case InstructionSet::avx512:  return "AVX-512";
+        case InstructionSet::scalar:  break;
+    }
+
+    return "scalar";
+}
+
+const Kernels& getKernels (InstructionSet instructionSet) noexcept
+{
+    const auto supported = juce::jmin (instructionSet, detectInstructionSet());
+
+   #if JUCE_INTEL
+    switch (supported)
+    {
+        case InstructionSet::avx512:  return getAvx512Kernels();
+        case InstructionSet::avx2:    return getAvx2Kernels();
+        case InstructionSet::sse2:    return getSse2Kernels();
+        case InstructionSet::scalar:  break;
+    }
+   #else
+    juce::ignoreUnused (supported);
+   #endif
+
+    return scalarKernels;
+}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Lets one function use an instruction set the rest of the build doesn't
+// assume, without changing how anything else is compiled. MSVC compiles
+// intrinsics for any set without flags.
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+ #define OBSIDIAN_TARGET(isa) __attribute__ ((target (isa)))
+#else
+ #define OBSIDIAN_TARGET(isa)
+#endif
+
+// The hot inner loops of the reverb, built once per instruction set and
+// picked at runtime, so one binary runs on every x86 generation and still
+// uses the widest vectors the machine has. The scalar variants are the
+// reference the others must agree with; Benchmarks/KernelTest checks that.
+// OutputStage's tone filters stay out: each recurs sample by sample, and the
+// two channels it runs side by side are too few lanes to gain from wider sets.
+namespace DspKernels
+{
+    enum class InstructionSet { scalar, sse2, avx2, avx512 };
+
+    // The eight Freeverb combs of each channel as sixteen independent lanes
+    // over one block of delay memory: lanes 0-7 are the left channel and
+    // 8-15 the right. Smaller networks use the first lanes of each channel.
+    struct CombBank
+    {
+        static constexpr int numLanes = 16;
+        static constexpr int lanesPerChannel = 8;
+
+        float* memory = nullptr;
+        alignas (64) std::array<int, (size_t) numLanes> offsets {};
+        alignas (64) std::array<int, (size_t) numLanes> sizes {};
+        alignas (64) std::array<int, (size_t) numLanes> indices {};
+        alignas (64) std::array<float, (size_t) numLanes> last {};
+    };
+
+    // Runs the first combs of each channel over a block, each feeding back
+    // input[i] plus its damped output scaled by feedback[i], and writes the
+    // summed outputs of each channel. outRight is only written for stereo.
+    using CombFunction = void (*) (CombBank& bank, const float* input, const float* damping, const float* feedback,
+                                   float* outLeft, float* outRight, int numSamples) noexcept;
+
+    // Comb networks are compiled for 1 or 2 channels of 4 or 8 combs, so
+    // every loop over lanes has a constant trip count.
+    constexpr int numCombVariants = 4;
+
+    constexpr int getCombVariant (int numChannels, int combsPerChannel) noexcept
+    {
+        return (numChannels - 1) * 2 + (combsPerChannel == CombBank::lanesPerChannel ? 1 : 0);
+    }
+
+    struct Kernels
+    {
+        InstructionSet instructionSet;
+
+        // Indexed by getCombVariant().
+        std::array<CombFunction, (size_t) numCombVariants> processCombs;
+
+        template <int numChannels, int combsPerChannel>
+        CombFunction getCombs() const noexcept
+        {
+            static_assert (numChannels == 1 || numChannels == 2, "Only mono and stereo networks are compiled");
+            static_assert (combsPerChannel == 4 || combsPerChannel == CombBank::lanesPerChannel, "Networks have 4 or 8 combs");
+            return processCombs[(size_t) getCombVariant (numChannels, combsPerChannel)];
+        }
+
+        // left = wetLeft * wet1 + wetRight * wet2 + left * dry, mirrored for right.
+        void (*mixStereo) (float* left, float* right, const float* wetLeft, const float* wetRight,
+                           const float* wet1, const float* wet2, const float* dry, int numSamples) noexcept;
+
+        // destination += source * gains, sample by sample.
+        void (*addWithGains) (float* destination, const float* source, const float* gains, int numSamples) noexcept;
+
+        // One spectral frame, in place over the interleaved bins: each bin's
+        // power feeds its energy, energy * decay + power * gain, and the bin
+        // becomes sqrt (energy) at a random phase drawn from its seed.
+        void (*resynthesiseBins) (float* spectrum, float* energy, juce::uint32* seeds,
+                                  const float* decay, const float* gain, int numBins) noexcept;
+    };
+
+    // The random phase of resynthesiseBins(): a xorshift step on the seed,
+    // read as a phase in half turns, with a quarter turn on for the cosine.
+    // The vector variants use this for their leftover bins.
+    constexpr float halfTurnsPerSeed = 1.0f / 2147483648.0f;
+
+    inline juce::uint32 nextSeed (juce::uint32 seed) noexcept
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        return seed ^ (seed << 5);
+    }
+
+    // sin (pi x) for x in [-1, 1): a parabola and one correction step, within
+    // 0.0011 of the real thing, with no branch or table to keep it in vectors.
+    inline float sinHalfTurns (float x) noexcept
+    {
+        const auto y = 4.0f * x * (1.0f - std::abs (x));
+        return y + 0.225f * (y * std::abs (y) - y);
+    }
+
+    inline void resynthesiseBin (float* bin, float& energy, juce::uint32& seed, float decay, float gain) noexcept
+    {
+        energy = energy * decay + gain * (bin[0] * bin[0] + bin[1] * bin[1]);
+        const auto magnitude = std::sqrt (energy);
+
+        seed = nextSeed (seed);
+        bin[0] = magnitude * sinHalfTurns ((float) (juce::int32) (seed + 0x40000000u) * halfTurnsPerSeed);
+        bin[1] = magnitude * sinHalfTurns ((float) (juce::int32) seed * halfTurnsPerSeed);
+    }
+
+    // Reads cpuid, and the OS's saved register state, once per process.
+    InstructionSet detectInstructionSet() noexcept;
+    const char* getName (InstructionSet instructionSet) noexcept;
+
+    // The requested variant, or the best one this machine supports below it.
+    const Kernels& getKernels (InstructionSet instructionSet) noexcept;
+    inline const Kernels& getBestKernels() noexcept { return getKernels (detectInstructionSet()); }
+
+    // Defined in DspKernels<set>.cpp; only call them for a supported set.
+   #if JUCE_INTEL
+    const Kernels& getSse2Kernels() noexcept;
+    const Kernels& getAvx2Kernels() noexcept;
+    const Kernels& getAvx512Kernels() noexcept;
+   #endif
+}
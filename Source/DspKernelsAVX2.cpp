@@ -0,0 +1,250 @@
+#include "DspKernels.h"
+
+#if JUCE_INTEL
+
+#include <immintrin.h>
+
+namespace DspKernels
+{
+namespace
+{
+    OBSIDIAN_TARGET ("avx2,fma") inline float sum (__m256 values) noexcept
+    {
+        auto half = _mm_add_ps (_mm256_castps256_ps128 (values), _mm256_extractf128_ps (values, 1));
+        half = _mm_add_ps (half, _mm_movehl_ps (half, half));
+        half = _mm_add_ss (half, _mm_shuffle_ps (half, half, 1));
+        return _mm_cvtss_f32 (half);
+    }
+
+    OBSIDIAN_TARGET ("avx2,fma") inline __m256 undenormalise (__m256 values) noexcept
+    {
+        const auto guard = _mm256_set1_ps (0.1f);
+        return _mm256_sub_ps (_mm256_add_ps (values, guard), guard);
+    }
+
+    OBSIDIAN_TARGET ("avx2,fma") inline float sum (__m128 values) noexcept
+    {
+        values = _mm_add_ps (values, _mm_movehl_ps (values, values));
+        values = _mm_add_ss (values, _mm_shuffle_ps (values, values, 1));
+        return _mm_cvtss_f32 (values);
+    }
+
+    OBSIDIAN_TARGET ("avx2,fma") inline __m128 undenormalise (__m128 values) noexcept
+    {
+        const auto guard = _mm_set1_ps (0.1f);
+        return _mm_sub_ps (_mm_add_ps (values, guard), guard);
+    }
+
+    // One channel's eight combs in a vector. The lines are gathered, and
+    // written back lane by lane since AVX2 has no scatter.
+    OBSIDIAN_TARGET ("avx2,fma")
+    void processEightCombs (CombBank& bank, int first, const float* input, const float* damping, const float* feedback,
+                            float* out, int numSamples) noexcept
+    {
+        auto* memory = bank.memory;
+        const auto one = _mm256_set1_ps (1.0f);
+        const auto step = _mm256_set1_epi32 (1);
+        alignas (32) float written[8];
+        alignas (32) int addresses[8];
+
+        const auto offsets = _mm256_load_si256 (reinterpret_cast<const __m256i*> (bank.offsets.data() + first));
+        const auto sizes = _mm256_load_si256 (reinterpret_cast<const __m256i*> (bank.sizes.data() + first));
+        auto indices = _mm256_load_si256 (reinterpret_cast<const __m256i*> (bank.indices.data() + first));
+        auto last = _mm256_load_ps (bank.last.data() + first);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto lineAddresses = _mm256_add_epi32 (offsets, indices);
+            const auto output = _mm256_i32gather_ps (memory, lineAddresses, 4);
+            const auto damp = _mm256_set1_ps (damping[i]);
+
+            last = undenormalise (_mm256_add_ps (_mm256_mul_ps (output, _mm256_sub_ps (one, damp)),
+                                                 _mm256_mul_ps (last, damp)));
+
+            const auto temp = undenormalise (_mm256_add_ps (_mm256_set1_ps (input[i]),
+                                                            _mm256_mul_ps (last, _mm256_set1_ps (feedback[i]))));
+
+            _mm256_store_ps (written, temp);
+            _mm256_store_si256 (reinterpret_cast<__m256i*> (addresses), lineAddresses);
+
+            for (int lane = 0; lane < 8; ++lane)
+                memory[addresses[lane]] = written[lane];
+
+            indices = _mm256_add_epi32 (indices, step);
+            indices = _mm256_and_si256 (indices, _mm256_cmpgt_epi32 (sizes, indices));
+
+            out[i] = sum (output);
+        }
+
+        _mm256_store_si256 (reinterpret_cast<__m256i*> (bank.indices.data() + first), indices);
+        _mm256_store_ps (bank.last.data() + first, last);
+    }
+
+    // The reduced network's four combs per channel, in half-width vectors.
+    OBSIDIAN_TARGET ("avx2,fma")
+    void processFourCombs (CombBank& bank, int first, const float* input, const float* damping, const float* feedback,
+                           float* out, int numSamples) noexcept
+    {
+        auto* memory = bank.memory;
+        const auto one = _mm_set1_ps (1.0f);
+        const auto step = _mm_set1_epi32 (1);
+        alignas (16) float written[4];
+        alignas (16) int addresses[4];
+
+        const auto offsets = _mm_load_si128 (reinterpret_cast<const __m128i*> (bank.offsets.data() + first));
+        const auto sizes = _mm_load_si128 (reinterpret_cast<const __m128i*> (bank.sizes.data() + first));
+        auto indices = _mm_load_si128 (reinterpret_cast<const __m128i*> (bank.indices.data() + first));
+        auto last = _mm_load_ps (bank.last.data() + first);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto lineAddresses = _mm_add_epi32 (offsets, indices);
+            const auto output = _mm_i32gather_ps (memory, lineAddresses, 4);
+            const auto damp = _mm_set1_ps (damping[i]);
+
+            last = undenormalise (_mm_add_ps (_mm_mul_ps (output, _mm_sub_ps (one, damp)), _mm_mul_ps (last, damp)));
+
+            const auto temp = undenormalise (_mm_add_ps (_mm_set1_ps (input[i]), _mm_mul_ps (last, _mm_set1_ps (feedback[i]))));
+
+            _mm_store_ps (written, temp);
+            _mm_store_si128 (reinterpret_cast<__m128i*> (addresses), lineAddresses);
+
+            for (int lane = 0; lane < 4; ++lane)
+                memory[addresses[lane]] = written[lane];
+
+            indices = _mm_add_epi32 (indices, step);
+            indices = _mm_and_si128 (indices, _mm_cmpgt_epi32 (sizes, indices));
+
+            out[i] = sum (output);
+        }
+
+        _mm_store_si128 (reinterpret_cast<__m128i*> (bank.indices.data() + first), indices);
+        _mm_store_ps (bank.last.data() + first, last);
+    }
+
+    template <int numChannels, int combsPerChannel>
+    OBSIDIAN_TARGET ("avx2,fma")
+    void processCombs (CombBank& bank, const float* input, const float* damping, const float* feedback,
+                       float* outLeft, float* outRight, int numSamples) noexcept
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto first = channel * CombBank::lanesPerChannel;
+            auto* out = channel == 0 ? outLeft : outRight;
+
+            if constexpr (combsPerChannel == 8)
+                processEightCombs (bank, first, input, damping, feedback, out, numSamples);
+            else
+                processFourCombs (bank, first, input, damping, feedback, out, numSamples);
+        }
+    }
+
+    OBSIDIAN_TARGET ("avx2,fma")
+    void mixStereo (float* left, float* right, const float* wetLeft, const float* wetRight,
+                    const float* wet1, const float* wet2, const float* dry, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const auto wl = _mm256_loadu_ps (wetLeft + i);
+            const auto wr = _mm256_loadu_ps (wetRight + i);
+            const auto w1 = _mm256_loadu_ps (wet1 + i);
+            const auto w2 = _mm256_loadu_ps (wet2 + i);
+            const auto d = _mm256_loadu_ps (dry + i);
+
+            const auto l = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (wl, w1), _mm256_mul_ps (wr, w2)),
+                                          _mm256_mul_ps (_mm256_loadu_ps (left + i), d));
+            const auto r = _mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (wr, w1), _mm256_mul_ps (wl, w2)),
+                                          _mm256_mul_ps (_mm256_loadu_ps (right + i), d));
+
+            _mm256_storeu_ps (left + i, l);
+            _mm256_storeu_ps (right + i, r);
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            const auto l = wetLeft[i] * wet1[i] + wetRight[i] * wet2[i] + left[i] * dry[i];
+            const auto r = wetRight[i] * wet1[i] + wetLeft[i] * wet2[i] + right[i] * dry[i];
+            left[i] = l;
+            right[i] = r;
+        }
+    }
+
+    OBSIDIAN_TARGET ("avx2,fma")
+    void addWithGains (float* destination, const float* source, const float* gains, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+            _mm256_storeu_ps (destination + i, _mm256_add_ps (_mm256_loadu_ps (destination + i),
+                                                              _mm256_mul_ps (_mm256_loadu_ps (source + i), _mm256_loadu_ps (gains + i))));
+
+        for (; i < numSamples; ++i)
+            destination[i] += source[i] * gains[i];
+    }
+
+    OBSIDIAN_TARGET ("avx2,fma") inline __m256 sinHalfTurns (__m256 x) noexcept
+    {
+        const auto absMask = _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff));
+        const auto y = _mm256_mul_ps (_mm256_mul_ps (_mm256_set1_ps (4.0f), x),
+                                      _mm256_sub_ps (_mm256_set1_ps (1.0f), _mm256_and_ps (x, absMask)));
+        return _mm256_add_ps (y, _mm256_mul_ps (_mm256_set1_ps (0.225f),
+                                                _mm256_sub_ps (_mm256_mul_ps (y, _mm256_and_ps (y, absMask)), y)));
+    }
+
+    // Eight bins per step. The in-lane shuffles leave the halves out of
+    // order, so a cross-lane permute puts them back either side.
+    OBSIDIAN_TARGET ("avx2,fma")
+    void resynthesiseBins (float* spectrum, float* energy, juce::uint32* seeds,
+                           const float* decay, const float* gain, int numBins) noexcept
+    {
+        const auto scale = _mm256_set1_ps (halfTurnsPerSeed);
+        const auto quarterTurn = _mm256_set1_epi32 (0x40000000);
+        int bin = 0;
+
+        for (; bin + 8 <= numBins; bin += 8)
+        {
+            const auto low = _mm256_loadu_ps (spectrum + 2 * bin);
+            const auto high = _mm256_loadu_ps (spectrum + 2 * bin + 8);
+            const auto real = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (_mm256_shuffle_ps (low, high, _MM_SHUFFLE (2, 0, 2, 0))),
+                                                                       _MM_SHUFFLE (3, 1, 2, 0)));
+            const auto imag = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (_mm256_shuffle_ps (low, high, _MM_SHUFFLE (3, 1, 3, 1))),
+                                                                       _MM_SHUFFLE (3, 1, 2, 0)));
+            const auto power = _mm256_add_ps (_mm256_mul_ps (real, real), _mm256_mul_ps (imag, imag));
+
+            const auto e = _mm256_add_ps (_mm256_mul_ps (_mm256_loadu_ps (energy + bin), _mm256_loadu_ps (decay + bin)),
+                                          _mm256_mul_ps (_mm256_loadu_ps (gain + bin), power));
+            _mm256_storeu_ps (energy + bin, e);
+            const auto magnitude = _mm256_sqrt_ps (e);
+
+            auto seed = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (seeds + bin));
+            seed = _mm256_xor_si256 (seed, _mm256_slli_epi32 (seed, 13));
+            seed = _mm256_xor_si256 (seed, _mm256_srli_epi32 (seed, 17));
+            seed = _mm256_xor_si256 (seed, _mm256_slli_epi32 (seed, 5));
+            _mm256_storeu_si256 (reinterpret_cast<__m256i*> (seeds + bin), seed);
+
+            const auto cosine = _mm256_mul_ps (magnitude, sinHalfTurns (_mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_add_epi32 (seed, quarterTurn)), scale)));
+            const auto sine = _mm256_mul_ps (magnitude, sinHalfTurns (_mm256_mul_ps (_mm256_cvtepi32_ps (seed), scale)));
+            const auto first = _mm256_unpacklo_ps (cosine, sine);
+            const auto second = _mm256_unpackhi_ps (cosine, sine);
+            _mm256_storeu_ps (spectrum + 2 * bin, _mm256_permute2f128_ps (first, second, 0x20));
+            _mm256_storeu_ps (spectrum + 2 * bin + 8, _mm256_permute2f128_ps (first, second, 0x31));
+        }
+
+        for (; bin < numBins; ++bin)
+            resynthesiseBin (spectrum + 2 * bin, energy[bin], seeds[bin], decay[bin], gain[bin]);
+    }
+
+    const Kernels avx2Kernels { InstructionSet::avx2,
+                                { processCombs<1, 4>, processCombs<1, 8>, processCombs<2, 4>, processCombs<2, 8> },
+                                mixStereo, addWithGains, resynthesiseBins };
+}
+
+const Kernels& getAvx2Kernels() noexcept
+{
+    return avx2Kernels;
+}
+}
+
+#endif
@@ -0,0 +1,179 @@
+#include "DspKernels.h"
+
+#if JUCE_INTEL
+
+#include <immintrin.h>
+
+namespace DspKernels
+{
+namespace
+{
+    OBSIDIAN_TARGET ("avx512f,avx2,fma") inline float sum (__m256 values) noexcept
+    {
+        auto half = _mm_add_ps (_mm256_castps256_ps128 (values), _mm256_extractf128_ps (values, 1));
+        half = _mm_add_ps (half, _mm_movehl_ps (half, half));
+        half = _mm_add_ss (half, _mm_shuffle_ps (half, half, 1));
+        return _mm_cvtss_f32 (half);
+    }
+
+    OBSIDIAN_TARGET ("avx512f,avx2,fma") inline __m512 undenormalise (__m512 values) noexcept
+    {
+        const auto guard = _mm512_set1_ps (0.1f);
+        return _mm512_sub_ps (_mm512_add_ps (values, guard), guard);
+    }
+
+    // All sixteen combs in one vector, with both channels' lines gathered
+    // and scattered together. Lanes outside the network are masked off, and
+    // gather as zero so they drop out of the sums.
+    template <int numChannels, int combsPerChannel>
+    OBSIDIAN_TARGET ("avx512f,avx2,fma")
+    void processCombs (CombBank& bank, const float* input, const float* damping, const float* feedback,
+                       float* outLeft, float* outRight, int numSamples) noexcept
+    {
+        constexpr auto channelMask = (1u << combsPerChannel) - 1u;
+        constexpr auto active = (__mmask16) (numChannels == 2 ? channelMask | (channelMask << CombBank::lanesPerChannel)
+                                                              : channelMask);
+
+        auto* memory = bank.memory;
+        const auto one = _mm512_set1_ps (1.0f);
+        const auto step = _mm512_set1_epi32 (1);
+
+        const auto offsets = _mm512_load_si512 (bank.offsets.data());
+        const auto sizes = _mm512_load_si512 (bank.sizes.data());
+        auto indices = _mm512_load_si512 (bank.indices.data());
+        auto last = _mm512_load_ps (bank.last.data());
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto lineAddresses = _mm512_add_epi32 (offsets, indices);
+            const auto output = _mm512_mask_i32gather_ps (_mm512_setzero_ps(), active, lineAddresses, memory, 4);
+            const auto damp = _mm512_set1_ps (damping[i]);
+
+            last = undenormalise (_mm512_add_ps (_mm512_mul_ps (output, _mm512_sub_ps (one, damp)), _mm512_mul_ps (last, damp)));
+
+            const auto temp = undenormalise (_mm512_add_ps (_mm512_set1_ps (input[i]), _mm512_mul_ps (last, _mm512_set1_ps (feedback[i]))));
+            _mm512_mask_i32scatter_ps (memory, active, lineAddresses, temp, 4);
+
+            indices = _mm512_add_epi32 (indices, step);
+            indices = _mm512_maskz_mov_epi32 (_mm512_cmplt_epi32_mask (indices, sizes), indices);
+
+            outLeft[i] = sum (_mm512_castps512_ps256 (output));
+
+            if constexpr (numChannels == 2)
+                outRight[i] = sum (_mm256_castpd_ps (_mm512_extractf64x4_pd (_mm512_castps_pd (output), 1)));
+        }
+
+        // Inactive lanes computed nothing meaningful; keep their state.
+        _mm512_mask_store_epi32 (bank.indices.data(), active, indices);
+        _mm512_mask_store_ps (bank.last.data(), active, last);
+    }
+
+    OBSIDIAN_TARGET ("avx512f,avx2,fma")
+    void mixStereo (float* left, float* right, const float* wetLeft, const float* wetRight,
+                    const float* wet1, const float* wet2, const float* dry, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 16 <= numSamples; i += 16)
+        {
+            const auto wl = _mm512_loadu_ps (wetLeft + i);
+            const auto wr = _mm512_loadu_ps (wetRight + i);
+            const auto w1 = _mm512_loadu_ps (wet1 + i);
+            const auto w2 = _mm512_loadu_ps (wet2 + i);
+            const auto d = _mm512_loadu_ps (dry + i);
+
+            const auto l = _mm512_add_ps (_mm512_add_ps (_mm512_mul_ps (wl, w1), _mm512_mul_ps (wr, w2)),
+                                          _mm512_mul_ps (_mm512_loadu_ps (left + i), d));
+            const auto r = _mm512_add_ps (_mm512_add_ps (_mm512_mul_ps (wr, w1), _mm512_mul_ps (wl, w2)),
+                                          _mm512_mul_ps (_mm512_loadu_ps (right + i), d));
+
+            _mm512_storeu_ps (left + i, l);
+            _mm512_storeu_ps (right + i, r);
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            const auto l = wetLeft[i] * wet1[i] + wetRight[i] * wet2[i] + left[i] * dry[i];
+            const auto r = wetRight[i] * wet1[i] + wetLeft[i] * wet2[i] + right[i] * dry[i];
+            left[i] = l;
+            right[i] = r;
+        }
+    }
+
+    OBSIDIAN_TARGET ("avx512f,avx2,fma")
+    void addWithGains (float* destination, const float* source, const float* gains, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 16 <= numSamples; i += 16)
+            _mm512_storeu_ps (destination + i, _mm512_add_ps (_mm512_loadu_ps (destination + i),
+                                                              _mm512_mul_ps (_mm512_loadu_ps (source + i), _mm512_loadu_ps (gains + i))));
+
+        for (; i < numSamples; ++i)
+            destination[i] += source[i] * gains[i];
+    }
+
+    OBSIDIAN_TARGET ("avx512f,avx2,fma") inline __m512 sinHalfTurns (__m512 x) noexcept
+    {
+        // AVX-512F has no float AND, so |x| goes through the integer one.
+        const auto absMask = _mm512_set1_epi32 (0x7fffffff);
+        const auto absX = _mm512_castsi512_ps (_mm512_and_si512 (_mm512_castps_si512 (x), absMask));
+        const auto y = _mm512_mul_ps (_mm512_mul_ps (_mm512_set1_ps (4.0f), x), _mm512_sub_ps (_mm512_set1_ps (1.0f), absX));
+        const auto absY = _mm512_castsi512_ps (_mm512_and_si512 (_mm512_castps_si512 (y), absMask));
+        return _mm512_add_ps (y, _mm512_mul_ps (_mm512_set1_ps (0.225f), _mm512_sub_ps (_mm512_mul_ps (y, absY), y)));
+    }
+
+    // Sixteen bins per step, split and merged with two-source permutes.
+    OBSIDIAN_TARGET ("avx512f,avx2,fma")
+    void resynthesiseBins (float* spectrum, float* energy, juce::uint32* seeds,
+                           const float* decay, const float* gain, int numBins) noexcept
+    {
+        const auto scale = _mm512_set1_ps (halfTurnsPerSeed);
+        const auto quarterTurn = _mm512_set1_epi32 (0x40000000);
+        const auto evens = _mm512_setr_epi32 (0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+        const auto odds = _mm512_setr_epi32 (1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+        const auto firstHalf = _mm512_setr_epi32 (0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+        const auto secondHalf = _mm512_setr_epi32 (8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+        int bin = 0;
+
+        for (; bin + 16 <= numBins; bin += 16)
+        {
+            const auto low = _mm512_loadu_ps (spectrum + 2 * bin);
+            const auto high = _mm512_loadu_ps (spectrum + 2 * bin + 16);
+            const auto real = _mm512_permutex2var_ps (low, evens, high);
+            const auto imag = _mm512_permutex2var_ps (low, odds, high);
+            const auto power = _mm512_add_ps (_mm512_mul_ps (real, real), _mm512_mul_ps (imag, imag));
+
+            const auto e = _mm512_add_ps (_mm512_mul_ps (_mm512_loadu_ps (energy + bin), _mm512_loadu_ps (decay + bin)),
+                                          _mm512_mul_ps (_mm512_loadu_ps (gain + bin), power));
+            _mm512_storeu_ps (energy + bin, e);
+            const auto magnitude = _mm512_sqrt_ps (e);
+
+            auto seed = _mm512_loadu_si512 (seeds + bin);
+            seed = _mm512_xor_si512 (seed, _mm512_slli_epi32 (seed, 13));
+            seed = _mm512_xor_si512 (seed, _mm512_srli_epi32 (seed, 17));
+            seed = _mm512_xor_si512 (seed, _mm512_slli_epi32 (seed, 5));
+            _mm512_storeu_si512 (seeds + bin, seed);
+
+            const auto cosine = _mm512_mul_ps (magnitude, sinHalfTurns (_mm512_mul_ps (_mm512_cvtepi32_ps (_mm512_add_epi32 (seed, quarterTurn)), scale)));
+            const auto sine = _mm512_mul_ps (magnitude, sinHalfTurns (_mm512_mul_ps (_mm512_cvtepi32_ps (seed), scale)));
+            _mm512_storeu_ps (spectrum + 2 * bin, _mm512_permutex2var_ps (cosine, firstHalf, sine));
+            _mm512_storeu_ps (spectrum + 2 * bin + 16, _mm512_permutex2var_ps (cosine, secondHalf, sine));
+        }
+
+        for (; bin < numBins; ++bin)
+            resynthesiseBin (spectrum + 2 * bin, energy[bin], seeds[bin], decay[bin], gain[bin]);
+    }
+
+    const Kernels avx512Kernels { InstructionSet::avx512,
+                                  { processCombs<1, 4>, processCombs<1, 8>, processCombs<2, 4>, processCombs<2, 8> },
+                                  mixStereo, addWithGains, resynthesiseBins };
+}
+
+const Kernels& getAvx512Kernels() noexcept
+{
+    return avx512Kernels;
+}
+}
+
+#endif
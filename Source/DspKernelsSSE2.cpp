@@ -0,0 +1,176 @@
+#include "DspKernels.h"
+
+#if JUCE_INTEL
+
+#include <emmintrin.h>
+
+namespace DspKernels
+{
+namespace
+{
+    OBSIDIAN_TARGET ("sse2") inline float sum (__m128 values) noexcept
+    {
+        values = _mm_add_ps (values, _mm_movehl_ps (values, values));
+        values = _mm_add_ss (values, _mm_shuffle_ps (values, values, 1));
+        return _mm_cvtss_f32 (values);
+    }
+
+    OBSIDIAN_TARGET ("sse2") inline __m128 undenormalise (__m128 values) noexcept
+    {
+        const auto guard = _mm_set1_ps (0.1f);
+        return _mm_sub_ps (_mm_add_ps (values, guard), guard);
+    }
+
+    // Four combs per vector, one or two vectors per channel. SSE2 has neither
+    // gather nor scatter, so the lines are read and written lane by lane.
+    template <int numChannels, int combsPerChannel>
+    OBSIDIAN_TARGET ("sse2")
+    void processCombs (CombBank& bank, const float* input, const float* damping, const float* feedback,
+                       float* outLeft, float* outRight, int numSamples) noexcept
+    {
+        static_assert (combsPerChannel % 4 == 0, "Combs are processed four at a time");
+
+        auto* memory = bank.memory;
+        const auto one = _mm_set1_ps (1.0f);
+        const auto step = _mm_set1_epi32 (1);
+        alignas (16) float written[4];
+        alignas (16) int addresses[4];
+
+        for (int group = 0; group < numChannels * combsPerChannel / 4; ++group)
+        {
+            const auto channel = group / (combsPerChannel / 4);
+            const auto first = channel * CombBank::lanesPerChannel + (group % (combsPerChannel / 4)) * 4;
+            const auto offsets = _mm_load_si128 (reinterpret_cast<const __m128i*> (bank.offsets.data() + first));
+            const auto sizes = _mm_load_si128 (reinterpret_cast<const __m128i*> (bank.sizes.data() + first));
+            auto indices = _mm_load_si128 (reinterpret_cast<const __m128i*> (bank.indices.data() + first));
+            auto last = _mm_load_ps (bank.last.data() + first);
+            auto* out = channel == 0 ? outLeft : outRight;
+            const auto isFirstOfChannel = first % CombBank::lanesPerChannel == 0;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                _mm_store_si128 (reinterpret_cast<__m128i*> (addresses), _mm_add_epi32 (offsets, indices));
+                const auto output = _mm_setr_ps (memory[addresses[0]], memory[addresses[1]],
+                                                 memory[addresses[2]], memory[addresses[3]]);
+                const auto damp = _mm_set1_ps (damping[i]);
+
+                last = undenormalise (_mm_add_ps (_mm_mul_ps (output, _mm_sub_ps (one, damp)), _mm_mul_ps (last, damp)));
+
+                const auto temp = undenormalise (_mm_add_ps (_mm_set1_ps (input[i]), _mm_mul_ps (last, _mm_set1_ps (feedback[i]))));
+                _mm_store_ps (written, temp);
+
+                for (int lane = 0; lane < 4; ++lane)
+                    memory[addresses[lane]] = written[lane];
+
+                indices = _mm_add_epi32 (indices, step);
+                indices = _mm_and_si128 (indices, _mm_cmpgt_epi32 (sizes, indices));
+
+                out[i] = isFirstOfChannel ? sum (output) : out[i] + sum (output);
+            }
+
+            _mm_store_si128 (reinterpret_cast<__m128i*> (bank.indices.data() + first), indices);
+            _mm_store_ps (bank.last.data() + first, last);
+        }
+    }
+
+    OBSIDIAN_TARGET ("sse2")
+    void mixStereo (float* left, float* right, const float* wetLeft, const float* wetRight,
+                    const float* wet1, const float* wet2, const float* dry, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const auto wl = _mm_loadu_ps (wetLeft + i);
+            const auto wr = _mm_loadu_ps (wetRight + i);
+            const auto w1 = _mm_loadu_ps (wet1 + i);
+            const auto w2 = _mm_loadu_ps (wet2 + i);
+            const auto d = _mm_loadu_ps (dry + i);
+
+            const auto l = _mm_add_ps (_mm_add_ps (_mm_mul_ps (wl, w1), _mm_mul_ps (wr, w2)), _mm_mul_ps (_mm_loadu_ps (left + i), d));
+            const auto r = _mm_add_ps (_mm_add_ps (_mm_mul_ps (wr, w1), _mm_mul_ps (wl, w2)), _mm_mul_ps (_mm_loadu_ps (right + i), d));
+
+            _mm_storeu_ps (left + i, l);
+            _mm_storeu_ps (right + i, r);
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            const auto l = wetLeft[i] * wet1[i] + wetRight[i] * wet2[i] + left[i] * dry[i];
+            const auto r = wetRight[i] * wet1[i] + wetLeft[i] * wet2[i] + right[i] * dry[i];
+            left[i] = l;
+            right[i] = r;
+        }
+    }
+
+    OBSIDIAN_TARGET ("sse2")
+    void addWithGains (float* destination, const float* source, const float* gains, int numSamples) noexcept
+    {
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+            _mm_storeu_ps (destination + i, _mm_add_ps (_mm_loadu_ps (destination + i),
+                                                        _mm_mul_ps (_mm_loadu_ps (source + i), _mm_loadu_ps (gains + i))));
+
+        for (; i < numSamples; ++i)
+            destination[i] += source[i] * gains[i];
+    }
+
+    OBSIDIAN_TARGET ("sse2") inline __m128 sinHalfTurns (__m128 x) noexcept
+    {
+        const auto absMask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+        const auto y = _mm_mul_ps (_mm_mul_ps (_mm_set1_ps (4.0f), x), _mm_sub_ps (_mm_set1_ps (1.0f), _mm_and_ps (x, absMask)));
+        return _mm_add_ps (y, _mm_mul_ps (_mm_set1_ps (0.225f), _mm_sub_ps (_mm_mul_ps (y, _mm_and_ps (y, absMask)), y)));
+    }
+
+    // Four bins per step: the interleaved pairs are split into real and
+    // imaginary vectors on the way in and merged again on the way out.
+    OBSIDIAN_TARGET ("sse2")
+    void resynthesiseBins (float* spectrum, float* energy, juce::uint32* seeds,
+                           const float* decay, const float* gain, int numBins) noexcept
+    {
+        const auto scale = _mm_set1_ps (halfTurnsPerSeed);
+        const auto quarterTurn = _mm_set1_epi32 (0x40000000);
+        int bin = 0;
+
+        for (; bin + 4 <= numBins; bin += 4)
+        {
+            const auto low = _mm_loadu_ps (spectrum + 2 * bin);
+            const auto high = _mm_loadu_ps (spectrum + 2 * bin + 4);
+            const auto real = _mm_shuffle_ps (low, high, _MM_SHUFFLE (2, 0, 2, 0));
+            const auto imag = _mm_shuffle_ps (low, high, _MM_SHUFFLE (3, 1, 3, 1));
+            const auto power = _mm_add_ps (_mm_mul_ps (real, real), _mm_mul_ps (imag, imag));
+
+            const auto e = _mm_add_ps (_mm_mul_ps (_mm_loadu_ps (energy + bin), _mm_loadu_ps (decay + bin)),
+                                       _mm_mul_ps (_mm_loadu_ps (gain + bin), power));
+            _mm_storeu_ps (energy + bin, e);
+            const auto magnitude = _mm_sqrt_ps (e);
+
+            auto seed = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (seeds + bin));
+            seed = _mm_xor_si128 (seed, _mm_slli_epi32 (seed, 13));
+            seed = _mm_xor_si128 (seed, _mm_srli_epi32 (seed, 17));
+            seed = _mm_xor_si128 (seed, _mm_slli_epi32 (seed, 5));
+            _mm_storeu_si128 (reinterpret_cast<__m128i*> (seeds + bin), seed);
+
+            const auto cosine = _mm_mul_ps (magnitude, sinHalfTurns (_mm_mul_ps (_mm_cvtepi32_ps (_mm_add_epi32 (seed, quarterTurn)), scale)));
+            const auto sine = _mm_mul_ps (magnitude, sinHalfTurns (_mm_mul_ps (_mm_cvtepi32_ps (seed), scale)));
+            _mm_storeu_ps (spectrum + 2 * bin, _mm_unpacklo_ps (cosine, sine));
+            _mm_storeu_ps (spectrum + 2 * bin + 4, _mm_unpackhi_ps (cosine, sine));
+        }
+
+        for (; bin < numBins; ++bin)
+            resynthesiseBin (spectrum + 2 * bin, energy[bin], seeds[bin], decay[bin], gain[bin]);
+    }
+
+    const Kernels sse2Kernels { InstructionSet::sse2,
+                                { processCombs<1, 4>, processCombs<1, 8>, processCombs<2, 4>, processCombs<2, 8> },
+                                mixStereo, addWithGains, resynthesiseBins };
+}
+
+const Kernels& getSse2Kernels() noexcept
+{
+    return sse2Kernels;
+}
+}
+
+#endif
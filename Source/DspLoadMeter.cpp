@@ -0,0 +1,66 @@
+#include "DspLoadMeter.h"
+
+DspLoadMeter::ScopedTimer::ScopedTimer (DspLoadMeter& meterToUse, int numSamplesInBlock) noexcept
+    : meter (meterToUse),
+      numSamples (numSamplesInBlock),
+      startTicks (juce::Time::getHighResolutionTicks())
+{
+}
+
+DspLoadMeter::ScopedTimer::~ScopedTimer() noexcept
+{
+    meter.addBlock (juce::Time::getHighResolutionTicks() - startTicks, numSamples);
+}
+
+//==============================================================================
+void DspLoadMeter::prepare (double sampleRate)
+{
+    jassert (sampleRate > 0.0);
+    secondsPerSample = 1.0 / sampleRate;
+    currentSampleRate.store (sampleRate, std::memory_order_relaxed);
+    reset();
+}
+
+void DspLoadMeter::reset() noexcept
+{
+    lastBlockLoad = 0.0f;
+    lastBlockSize = 0;
+    averageLoad.store (0.0f, std::memory_order_relaxed);
+    peakLoad.store (0.0f, std::memory_order_relaxed);
+    overruns.store (0, std::memory_order_relaxed);
+}
+
+DspLoadMeter::Snapshot DspLoadMeter::getSnapshot() const noexcept
+{
+    Snapshot snapshot;
+    snapshot.sampleRate = currentSampleRate.load (std::memory_order_relaxed);
+    snapshot.averageLoad = averageLoad.load (std::memory_order_relaxed);
+    snapshot.peakLoad = peakLoad.load (std::memory_order_relaxed);
+    snapshot.overruns = overruns.load (std::memory_order_relaxed);
+    return snapshot;
+}
+
+void DspLoadMeter::addBlock (juce::int64 elapsedTicks, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    const auto budgetSeconds = (double) numSamples * secondsPerSample;
+    const auto load = (float) ((double) elapsedTicks * secondsPerTick / budgetSeconds);
+
+    lastBlockLoad = load;
+    lastBlockSize = numSamples;
+
+    if (load > 1.0f)
+        overruns.store (overruns.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    // One-pole smoothing with a time constant in real time rather than in blocks,
+    // so the average reads the same whatever buffer size the host uses.
+    const auto averageCoeff = (float) (budgetSeconds / (budgetSeconds + averagingTimeSeconds));
+    const auto average = averageLoad.load (std::memory_order_relaxed);
+    averageLoad.store (average + (load - average) * averageCoeff, std::memory_order_relaxed);
+
+    const auto peakRelease = (float) juce::jmin (1.0, budgetSeconds / peakReleaseSeconds);
+    const auto peak = peakLoad.load (std::memory_order_relaxed);
+    peakLoad.store (juce::jmax (load, peak - peak * peakRelease), std::memory_order_relaxed);
+}
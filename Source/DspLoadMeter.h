@@ -0,0 +1,59 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Measures how long processBlock takes relative to the real-time deadline of
+// the block. Written only from the audio thread, read without locks from the UI.
+class DspLoadMeter
+{
+public:
+    struct Snapshot
+    {
+        double sampleRate = 0.0;
+        float averageLoad = 0.0f;
+        float peakLoad = 0.0f;
+        juce::uint32 overruns = 0;
+    };
+
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer (DspLoadMeter& meterToUse, int numSamplesInBlock) noexcept;
+        ~ScopedTimer() noexcept;
+
+    private:
+        DspLoadMeter& meter;
+        const int numSamples;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedTimer)
+    };
+
+    void prepare (double sampleRate);
+    void reset() noexcept;
+
+    Snapshot getSnapshot() const noexcept;
+
+    // The block timed most recently. Audio thread only.
+    float getLastBlockLoad() const noexcept { return lastBlockLoad; }
+    int getLastBlockSize() const noexcept { return lastBlockSize; }
+
+private:
+    void addBlock (juce::int64 elapsedTicks, int numSamples) noexcept;
+
+    static constexpr double averagingTimeSeconds = 1.0;
+    static constexpr double peakReleaseSeconds = 2.0;
+
+    double secondsPerTick = 1.0 / (double) juce::Time::getHighResolutionTicksPerSecond();
+    double secondsPerSample = 1.0 / 44100.0;
+    float lastBlockLoad = 0.0f;
+    int lastBlockSize = 0;
+
+    std::atomic<double> currentSampleRate { 0.0 };
+    std::atomic<float> averageLoad { 0.0f };
+    std::atomic<float> peakLoad { 0.0f };
+    std::atomic<juce::uint32> overruns { 0 };
+
+    static_assert (std::atomic<double>::is_always_lock_free, "Load meter must be lock-free");
+    static_assert (std::atomic<float>::is_always_lock_free, "Load meter must be lock-free");
+};
@@ -0,0 +1,33 @@
+#include "EditorPreferences.h"
+
+namespace
+{
+    const char* const maximumFrameRateKey = "maxFrameRate";
+}
+
+EditorPreferences::EditorPreferences()
+{
+    juce::PropertiesFile::Options options;
+    options.applicationName = "Obsidian Space";
+    options.filenameSuffix = ".settings";
+    options.folderName = "CK Audio Design";
+    options.osxLibrarySubFolder = "Application Support";
+    properties = std::make_unique<juce::PropertiesFile> (options);
+}
+
+const juce::Array<int>& EditorPreferences::getFrameRateChoices()
+{
+    static const juce::Array<int> choices { 15, 30, 60, 120 };
+    return choices;
+}
+
+int EditorPreferences::getMaximumFrameRate() const
+{
+    return juce::jlimit (1, 240, properties->getIntValue (maximumFrameRateKey, defaultFrameRate));
+}
+
+void EditorPreferences::setMaximumFrameRate (int framesPerSecond)
+{
+    properties->setValue (maximumFrameRateKey, framesPerSecond);
+    properties->saveIfNeeded();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Per-user editor settings, shared by every open editor in the process.
+// Use through juce::SharedResourcePointer<EditorPreferences>.
+class EditorPreferences
+{
+public:
+    EditorPreferences();
+
+    int getMaximumFrameRate() const;
+    void setMaximumFrameRate (int framesPerSecond);
+
+    static constexpr int defaultFrameRate = 60;
+    static const juce::Array<int>& getFrameRateChoices();
+
+private:
+    std::unique_ptr<juce::PropertiesFile> properties;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EditorPreferences)
+};
@@ -0,0 +1,52 @@
+#include "FactoryPresets.h"
+
+namespace
+{
+    ReverbSettings makeSettings (float roomSize, float decay, float preDelay, float damping,
+                                 float mix, float width, float lowCut, float highCut)
+    {
+        ReverbSettings settings;
+        settings.roomSize = roomSize;
+        settings.decay = decay;
+        settings.preDelay = preDelay;
+        settings.damping = damping;
+        settings.mix = mix;
+        settings.width = width;
+        settings.lowCut = lowCut;
+        settings.highCut = highCut;
+        return settings;
+    }
+
+    // The first entry matches the parameter defaults.
+    const std::array<FactoryPreset, 8> presets
+    {{
+        { "Init",           makeSettings (50.0f, 2.5f, 20.0f,  8000.0f, 30.0f, 100.0f,  20.0f, 12000.0f) },
+        { "Obsidian Hall",  makeSettings (70.0f, 4.0f, 30.0f,  7000.0f, 35.0f, 100.0f,  80.0f, 11000.0f) },
+        { "Small Chamber",  makeSettings (30.0f, 1.2f,  8.0f,  9000.0f, 25.0f,  80.0f, 120.0f, 14000.0f) },
+        { "Dark Plate",     makeSettings (55.0f, 2.8f, 12.0f,  4000.0f, 30.0f, 120.0f, 150.0f,  8000.0f) },
+        { "Bright Room",    makeSettings (40.0f, 1.6f, 15.0f, 16000.0f, 22.0f, 100.0f, 200.0f, 18000.0f) },
+        { "Tight Ambience", makeSettings (15.0f, 0.6f,  0.0f, 12000.0f, 18.0f,  60.0f, 250.0f, 16000.0f) },
+        { "Ambient Wash",   makeSettings (85.0f, 6.5f, 45.0f,  6000.0f, 50.0f, 160.0f, 100.0f, 10000.0f) },
+        { "Vast Void",      makeSettings (95.0f, 9.0f, 80.0f,  5000.0f, 45.0f, 180.0f,  60.0f,  9000.0f) }
+    }};
+}
+
+int FactoryPresets::getNumPresets() noexcept
+{
+    return (int) presets.size();
+}
+
+const FactoryPreset& FactoryPresets::get (int index) noexcept
+{
+    jassert (juce::isPositiveAndBelow (index, getNumPresets()));
+    return presets[(size_t) juce::jlimit (0, getNumPresets() - 1, index)];
+}
+
+int FactoryPresets::indexOf (const juce::String& name)
+{
+    for (int i = 0; i < getNumPresets(); ++i)
+        if (name == presets[(size_t) i].name)
+            return i;
+
+    return -1;
+}
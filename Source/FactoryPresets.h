@@ -0,0 +1,20 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ReverbSettings.h"
+
+// The read-only preset bank exposed to hosts through the program API.
+struct FactoryPreset
+{
+    const char* name;
+    ReverbSettings settings;
+};
+
+namespace FactoryPresets
+{
+    int getNumPresets() noexcept;
+    const FactoryPreset& get (int index) noexcept;
+
+    // Returns -1 if no preset has that name.
+    int indexOf (const juce::String& name);
+}
@@ -10,6 +10,62 @@ void FooterComponent::setPowerParam (std::atomic<float>* param)
     repaint();
 }
 
+void FooterComponent::setLoadMeter (const DspLoadMeter* meter)
+{
+    loadMeter = meter;
+
+    if (loadMeter != nullptr)
+    {
+        loadSnapshot = loadMeter->getSnapshot();
+        startTimerHz (4);
+    }
+    else
+    {
+        stopTimer();
+    }
+
+    repaint();
+}
+
+void FooterComponent::setQualityController (const QualityController* controller)
+{
+    qualityController = controller;
+    qualityLevel = controller != nullptr ? controller->getLevel() : QualityController::Level::full;
+    repaint();
+}
+
+void FooterComponent::timerCallback()
+{
+    auto snapshot = loadMeter->getSnapshot();
+    const auto level = qualityController != nullptr ? qualityController->getLevel() : QualityController::Level::full;
+
+    if (level != qualityLevel)
+    {
+        qualityLevel = level;
+        repaint();
+    }
+
+    if (snapshot.sampleRate != loadSnapshot.sampleRate
+        || snapshot.overruns != loadSnapshot.overruns
+        || std::abs (snapshot.averageLoad - loadSnapshot.averageLoad) > 0.001f
+        || std::abs (snapshot.peakLoad - loadSnapshot.peakLoad) > 0.001f)
+    {
+        loadSnapshot = snapshot;
+        repaint();
+    }
+}
+
+juce::String FooterComponent::formatSampleRate (double sampleRate)
+{
+    if (sampleRate <= 0.0)
+        return "--";
+
+    auto kHz = sampleRate / 1000.0;
+    if (std::abs (kHz - std::round (kHz)) < 0.05)
+        return juce::String (juce::roundToInt (kHz)) + "kHz";
+    return juce::String (kHz, 1) + "kHz";
+}
+
 void FooterComponent::paint (juce::Graphics& g)
 {
     auto bounds = getLocalBounds().toFloat();
@@ -17,7 +73,19 @@ void FooterComponent::paint (juce::Graphics& g)
     auto textBounds = bounds.reduced (32.0f, 6.0f);
     g.setColour (ObsidianStyle::textSecondary().withAlpha (0.7f));
     g.setFont (juce::Font (12.0f, juce::Font::plain));
-    g.drawText ("VERSION 1.0.0  |  48kHz / 24bit", textBounds, juce::Justification::centredLeft);
+
+    auto status = "VERSION 1.0.0  |  " + formatSampleRate (loadSnapshot.sampleRate);
+    if (loadMeter != nullptr)
+    {
+        status << "  |  DSP " << juce::String (loadSnapshot.averageLoad * 100.0f, 1) << "% AVG / "
+               << juce::String (loadSnapshot.peakLoad * 100.0f, 1) << "% PEAK"
+               << "  |  OVERRUNS " << juce::String ((int) loadSnapshot.overruns);
+    }
+
+    if (qualityLevel == QualityController::Level::reduced)
+        status << "  |  QUALITY REDUCED";
+
+    g.drawText (status, textBounds, juce::Justification::centredLeft);
 
     const bool isPowered = powerParam == nullptr || powerParam->load() > 0.5f;
     auto indicatorArea = textBounds.removeFromRight (120.0f);
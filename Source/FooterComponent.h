@@ -2,8 +2,11 @@
 
 #include <JuceHeader.h>
 #include "ObsidianSpaceLookAndFeel.h"
+#include "DspLoadMeter.h"
+#include "QualityController.h"
 
-class FooterComponent : public juce::Component
+class FooterComponent : public juce::Component,
+                        private juce::Timer
 {
 public:
     FooterComponent();
@@ -11,7 +14,16 @@ public:
 
     void paint (juce::Graphics& g) override;
     void setPowerParam (std::atomic<float>* param);
+    void setLoadMeter (const DspLoadMeter* meter);
+    void setQualityController (const QualityController* controller);
 
 private:
+    void timerCallback() override;
+    static juce::String formatSampleRate (double sampleRate);
+
     std::atomic<float>* powerParam = nullptr;
+    const DspLoadMeter* loadMeter = nullptr;
+    DspLoadMeter::Snapshot loadSnapshot;
+    const QualityController* qualityController = nullptr;
+    QualityController::Level qualityLevel = QualityController::Level::full;
 };
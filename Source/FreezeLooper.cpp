@@ -0,0 +1,124 @@
+#include "FreezeLooper.h"
+
+void FreezeLooper::prepare (double sampleRate, int numChannels)
+{
+    loopLength = juce::jmax (1, juce::roundToInt (sampleRate * loopSeconds));
+    crossfadeLength = juce::jmax (1, juce::roundToInt (sampleRate * crossfadeSeconds));
+    mixStep = 1.0f / (float) crossfadeLength;
+
+    loop.setSize (numChannels, loopLength, false, false, true);
+    reset();
+}
+
+void FreezeLooper::reset() noexcept
+{
+    state = State::off;
+    loopMix = 0.0f;
+    recordPosition = 0;
+    playPosition = 0;
+}
+
+void FreezeLooper::setFrozen (bool shouldBeFrozen) noexcept
+{
+    if (shouldBeFrozen)
+    {
+        if (state == State::off)
+        {
+            state = State::capturing;
+            recordPosition = 0;
+        }
+        else if (state == State::releasing)
+        {
+            state = State::looping;
+        }
+    }
+    else
+    {
+        if (state == State::capturing)
+            state = State::off;
+        else if (state == State::looping)
+            state = State::releasing;
+    }
+}
+
+void FreezeLooper::capture (const juce::dsp::AudioBlock<float>& wetBlock, int sample) noexcept
+{
+    const auto numChannels = juce::jmin ((int) wetBlock.getNumChannels(), loop.getNumChannels());
+
+    if (recordPosition < loopLength)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            loop.setSample (channel, recordPosition, wetBlock.getSample (channel, sample));
+    }
+    else
+    {
+        // Fold the overrun onto the start, fading the head in under it, so
+        // the last recorded sample runs straight into the first.
+        const auto position = recordPosition - loopLength;
+        const auto progress = (float) position / (float) crossfadeLength;
+        const auto headGain = std::sqrt (progress);
+        const auto tailGain = std::sqrt (1.0f - progress);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            loop.setSample (channel, position, loop.getSample (channel, position) * headGain
+                                                   + wetBlock.getSample (channel, sample) * tailGain);
+    }
+
+    if (++recordPosition == loopLength + crossfadeLength)
+    {
+        state = State::looping;
+        playPosition = crossfadeLength;
+    }
+}
+
+void FreezeLooper::process (juce::dsp::AudioBlock<float>& wetBlock, float wetLevel) noexcept
+{
+    if (state == State::off)
+        return;
+
+    const auto numChannels = (int) wetBlock.getNumChannels();
+    const auto numSamples = (int) wetBlock.getNumSamples();
+    const auto numLoopChannels = loop.getNumChannels();
+
+    if (state == State::capturing && recordPosition == 0)
+        capturedWetLevel = wetLevel;
+
+    const auto loopGain = capturedWetLevel > 0.0f ? wetLevel / capturedWetLevel : 0.0f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        if (state == State::capturing)
+        {
+            capture (wetBlock, i);
+            continue;
+        }
+
+        if (state == State::off)
+            break;
+
+        const auto engineGain = loopMix < 1.0f ? std::sqrt (1.0f - loopMix) : 0.0f;
+        const auto playGain = std::sqrt (loopMix) * loopGain;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* wet = wetBlock.getChannelPointer ((size_t) channel);
+            const auto looped = loop.getSample (juce::jmin (channel, numLoopChannels - 1), playPosition);
+            wet[i] = wet[i] * engineGain + looped * playGain;
+        }
+
+        if (++playPosition == loopLength)
+            playPosition = 0;
+
+        if (state == State::looping)
+        {
+            loopMix = juce::jmin (1.0f, loopMix + mixStep);
+        }
+        else if (state == State::releasing)
+        {
+            loopMix -= mixStep;
+
+            if (loopMix <= 0.0f)
+                reset();
+        }
+    }
+}
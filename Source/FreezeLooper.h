@@ -0,0 +1,46 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Holds a frozen tail without running the reverb network. Once frozen, the
+// engine's output is recorded for one loop length plus a crossfade, the end
+// of the recording is folded over its start so the loop wraps seamlessly,
+// and playback then takes over from the engine. Unfreezing fades the engine
+// back in over the loop.
+class FreezeLooper
+{
+public:
+    void prepare (double sampleRate, int numChannels);
+    void reset() noexcept;
+
+    // Audio thread. Call once per block before processing.
+    void setFrozen (bool shouldBeFrozen) noexcept;
+
+    // False while the loop alone is playing, so the engine can be skipped.
+    bool needsEngine() const noexcept { return state != State::looping || loopMix < 1.0f; }
+
+    // Takes the engine's wet output (ignored when needsEngine() is false)
+    // and replaces it with the blend of engine and loop. The wet level is
+    // the engine's current one, so mix changes still apply while looping.
+    void process (juce::dsp::AudioBlock<float>& wetBlock, float wetLevel) noexcept;
+
+    static constexpr double loopSeconds = 3.0;
+    static constexpr double crossfadeSeconds = 0.5;
+
+private:
+    enum class State { off, capturing, looping, releasing };
+
+    void capture (const juce::dsp::AudioBlock<float>& wetBlock, int sample) noexcept;
+
+    State state = State::off;
+    juce::AudioBuffer<float> loop;
+    int loopLength = 0;
+    int crossfadeLength = 0;
+    int recordPosition = 0;
+    int playPosition = 0;
+
+    // 0 is all engine, 1 is all loop.
+    float loopMix = 0.0f;
+    float mixStep = 0.0f;
+    float capturedWetLevel = 0.0f;
+};
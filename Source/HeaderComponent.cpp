@@ -9,6 +9,11 @@ HeaderComponent::HeaderComponent()
 }
 
 void HeaderComponent::paint (juce::Graphics& g)
+{
+    chromeLayer.draw (g, getLocalBounds(), [this] (juce::Graphics& layer) { renderChrome (layer); });
+}
+
+void HeaderComponent::renderChrome (juce::Graphics& g)
 {
     auto bounds = getLocalBounds().toFloat();
 
@@ -36,6 +41,8 @@ void HeaderComponent::paint (juce::Graphics& g)
 
 void HeaderComponent::resized()
 {
+    chromeLayer.invalidate();
+
     auto bounds = getLocalBounds().reduced (32, 10);
     const int buttonSize = 28;
     auto buttonY = bounds.getY() + (bounds.getHeight() - buttonSize) / 2;
@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include "ObsidianSpaceLookAndFeel.h"
+#include "CachedLayer.h"
 
 class HeaderComponent : public juce::Component
 {
@@ -14,6 +15,7 @@ public:
     juce::Button& getPowerButton();
 
 private:
+    void renderChrome (juce::Graphics& g);
     void drawTrackedText (juce::Graphics& g, const juce::String& text,
                           juce::Rectangle<float> area, juce::Font font, float tracking);
 
@@ -25,4 +27,7 @@ private:
     };
 
     PowerButton powerButton;
+
+    // Gradient, divider and titles; the power button paints itself on top.
+    CachedLayer chromeLayer;
 };
@@ -0,0 +1,281 @@
+#include "ImpulseResponseRenderer.h"
+
+ImpulseResponseRenderer::Client::Client()
+{
+    renderer->add (*this);
+}
+
+ImpulseResponseRenderer::Client::~Client()
+{
+    renderer->remove (*this);
+}
+
+void ImpulseResponseRenderer::Client::requestRender (const ReverbSettings& settings)
+{
+    renderer->request (*this, settings);
+}
+
+std::shared_ptr<const ImpulseResponseDisplay> ImpulseResponseRenderer::Client::getLatestResult() const
+{
+    const juce::ScopedLock sl (renderer->lock);
+    return latestResult;
+}
+
+//==============================================================================
+ImpulseResponseRenderer::ImpulseResponseRenderer()
+    : juce::Thread ("Obsidian Space IR Renderer")
+{
+    const juce::dsp::ProcessSpec spec { renderSampleRate, (juce::uint32) renderBlockSize, 2 };
+    engine.prepare (spec);
+    spectralEngine.prepare (spec);
+    velvetEngine.prepare (spec);
+
+    renderBuffer.setSize (2, (int) (renderSampleRate * maximumLengthSeconds));
+    cache.reserve (cacheSize);
+    startThread (juce::Thread::Priority::low);
+}
+
+ImpulseResponseRenderer::~ImpulseResponseRenderer()
+{
+    stopThread (2000);
+}
+
+void ImpulseResponseRenderer::add (Client& client)
+{
+    const juce::ScopedLock sl (lock);
+    clients.addIfNotAlreadyThere (&client);
+}
+
+void ImpulseResponseRenderer::remove (Client& client)
+{
+    const juce::ScopedLock sl (lock);
+    clients.removeAllInstancesOf (&client);
+}
+
+void ImpulseResponseRenderer::request (Client& client, const ReverbSettings& settings)
+{
+    const auto hash = settings.getTailHash();
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (client.requestedHash == hash
+            && (client.needsRender || (client.latestResult != nullptr && client.latestResult->hash == hash)))
+            return;
+
+        client.requestedHash = hash;
+
+        if (auto cached = findCached (hash))
+        {
+            client.needsRender = false;
+            client.latestResult = std::move (cached);
+        }
+        else
+        {
+            // Another client may already be rendering this hash, in which
+            // case its result reaches this one too.
+            client.pendingSettings = settings;
+            client.requestTime = juce::Time::getMillisecondCounter();
+            client.needsRender = true;
+            notify();
+            return;
+        }
+    }
+
+    client.sendChangeMessage();
+}
+
+void ImpulseResponseRenderer::run()
+{
+    while (! threadShouldExit())
+    {
+        ReverbSettings settings;
+        bool hasSettings = false;
+        int waitMs = -1;
+
+        {
+            const juce::ScopedLock sl (lock);
+            Client* oldest = nullptr;
+
+            for (auto* client : clients)
+                if (client->needsRender && (oldest == nullptr || (int) (client->requestTime - oldest->requestTime) < 0))
+                    oldest = client;
+
+            if (oldest != nullptr)
+            {
+                // Wait for the knob to settle before spending a render on it.
+                const auto sinceRequest = (int) (juce::Time::getMillisecondCounter() - oldest->requestTime);
+
+                if (sinceRequest < debounceMs)
+                {
+                    waitMs = debounceMs - sinceRequest;
+                }
+                else
+                {
+                    settings = oldest->pendingSettings;
+                    hasSettings = true;
+                }
+            }
+        }
+
+        if (! hasSettings)
+        {
+            wait (waitMs);
+            continue;
+        }
+
+        renderAndAnalyse (settings);
+    }
+}
+
+void ImpulseResponseRenderer::renderAndAnalyse (const ReverbSettings& settings)
+{
+    const auto hash = settings.getTailHash();
+    const auto length = render (settings, hash);
+
+    if (length == 0)
+        return;
+
+    ImpulseResponseDisplay display;
+    display.hash = hash;
+
+    for (int point = 0; point < ImpulseResponseDisplay::numPeaks; ++point)
+    {
+        const auto start = (int) ((juce::int64) length * point / ImpulseResponseDisplay::numPeaks);
+        const auto end = juce::jmax (start + 1, (int) ((juce::int64) length * (point + 1) / ImpulseResponseDisplay::numPeaks));
+        float peak = 0.0f;
+
+        for (int channel = 0; channel < renderBuffer.getNumChannels(); ++channel)
+        {
+            const auto* data = renderBuffer.getReadPointer (channel);
+
+            for (int i = start; i < end; ++i)
+                if (std::abs (data[i]) > std::abs (peak))
+                    peak = data[i];
+        }
+
+        display.peaks[(size_t) point] = peak;
+    }
+
+    analyzer.analyse (renderBuffer, length, renderSampleRate,
+                      [this, hash] { return threadShouldExit() || ! isWanted (hash); },
+                      [this, &display] (const DecayAnalysis& analysis)
+                      {
+                          display.decay = analysis;
+                          publish (std::make_shared<const ImpulseResponseDisplay> (display),
+                                   analysis.numBandsAnalysed == DecayAnalysis::numBands);
+                      });
+}
+
+int ImpulseResponseRenderer::render (const ReverbSettings& settings, juce::uint64 hash)
+{
+    const auto maximumLength = renderBuffer.getNumSamples();
+    const auto minimumLength = (int) (renderSampleRate * 0.5);
+    const auto silenceRatio = 3.0e-5f; // about -90 dB below the peak
+
+    if (settings.engine == ReverbSettings::engineSpectral)
+    {
+        spectralEngine.setParameters (settings.toWetSpectralParameters());
+        spectralEngine.reset();
+    }
+    else if (settings.engine == ReverbSettings::engineVelvet)
+    {
+        velvetEngine.setParameters (settings.toWetVelvetParameters());
+        velvetEngine.buildTablesNow (settings.decay, ReverbSettings::normaliseRoomSize (settings.roomSize));
+    }
+    else
+    {
+        engine.setParameters (settings.toWetReverbParameters());
+        engine.reset();
+    }
+
+    renderBuffer.clear();
+    renderBuffer.setSample (0, 0, 1.0f);
+    renderBuffer.setSample (1, 0, 1.0f);
+
+    juce::dsp::AudioBlock<float> wholeBlock (renderBuffer);
+    float overallPeak = 0.0f;
+
+    for (int position = 0; position < maximumLength; position += renderBlockSize)
+    {
+        if (threadShouldExit() || ! isWanted (hash))
+            return 0;
+
+        const auto numSamples = juce::jmin (renderBlockSize, maximumLength - position);
+        auto block = wholeBlock.getSubBlock ((size_t) position, (size_t) numSamples);
+        juce::dsp::ProcessContextReplacing<float> context (block);
+
+        if (settings.engine == ReverbSettings::engineSpectral)
+            spectralEngine.process (context);
+        else if (settings.engine == ReverbSettings::engineVelvet)
+            velvetEngine.process (context);
+        else
+            engine.process (context);
+
+        auto blockPeak = renderBuffer.getMagnitude (position, numSamples);
+        overallPeak = juce::jmax (overallPeak, blockPeak);
+
+        if (position + numSamples >= minimumLength && blockPeak < overallPeak * silenceRatio)
+            return position + numSamples;
+    }
+
+    return maximumLength;
+}
+
+bool ImpulseResponseRenderer::isWanted (juce::uint64 hash) const
+{
+    const juce::ScopedLock sl (lock);
+
+    for (auto* client : clients)
+        if (client->requestedHash == hash)
+            return true;
+
+    return false;
+}
+
+void ImpulseResponseRenderer::publish (std::shared_ptr<const ImpulseResponseDisplay> result, bool isComplete)
+{
+    const juce::ScopedLock sl (lock);
+
+    // Partial analyses are shown but not cached, since an abandoned one
+    // would never fill in.
+    if (isComplete)
+        addToCache (result);
+
+    for (auto* client : clients)
+    {
+        if (client->requestedHash == result->hash)
+        {
+            client->needsRender = false;
+            client->latestResult = result;
+            client->sendChangeMessage();
+        }
+    }
+}
+
+std::shared_ptr<const ImpulseResponseDisplay> ImpulseResponseRenderer::findCached (juce::uint64 hash)
+{
+    for (auto& entry : cache)
+    {
+        if (entry.result->hash == hash)
+        {
+            entry.lastUsed = ++cacheClock;
+            return entry.result;
+        }
+    }
+
+    return nullptr;
+}
+
+void ImpulseResponseRenderer::addToCache (std::shared_ptr<const ImpulseResponseDisplay> result)
+{
+    if (cache.size() < cacheSize)
+    {
+        cache.push_back ({ std::move (result), ++cacheClock });
+        return;
+    }
+
+    auto oldest = std::min_element (cache.begin(), cache.end(),
+                                    [] (const CacheEntry& a, const CacheEntry& b) { return a.lastUsed < b.lastUsed; });
+    *oldest = { std::move (result), ++cacheClock };
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ReverbSettings.h"
+#include "ReverbEngine.h"
+#include "SpectralEngine.h"
+#include "VelvetEngine.h"
+#include "DecayAnalyzer.h"
+
+// What the editor shows of the wet impulse response of one set of reverb
+// settings: the response reduced to a fixed number of peaks, and its decay.
+struct ImpulseResponseDisplay
+{
+    static constexpr int numPeaks = 1024;
+
+    juce::uint64 hash = 0;
+
+    // The signed sample of largest magnitude, over both channels, in each of
+    // numPeaks even slices of the response.
+    std::array<float, (size_t) numPeaks> peaks {};
+
+    DecayAnalysis decay;
+};
+
+// One low-priority thread per process renders impulse responses for every
+// open editor, through its own copy of whichever engine the settings select,
+// then reduces each one to display data and analyses its decay. Requests are
+// debounced while parameters keep moving, and a render is abandoned as soon
+// as no client wants it any more. Finished display data is kept in a small
+// LRU cache keyed by the tail hash; full responses are not kept. Shared
+// through a SharedResourcePointer, which each Client holds.
+class ImpulseResponseRenderer : private juce::Thread
+{
+public:
+    // One per editor. Listeners are told on the message thread when the
+    // result for the latest request arrives, and again as its decay bands
+    // fill in.
+    class Client : public juce::ChangeBroadcaster
+    {
+    public:
+        Client();
+        ~Client() override;
+
+        // Message thread.
+        void requestRender (const ReverbSettings& settings);
+        std::shared_ptr<const ImpulseResponseDisplay> getLatestResult() const;
+
+    private:
+        friend class ImpulseResponseRenderer;
+
+        juce::SharedResourcePointer<ImpulseResponseRenderer> renderer;
+
+        // Guarded by the renderer's lock.
+        ReverbSettings pendingSettings;
+        juce::uint64 requestedHash = 0;
+        juce::uint32 requestTime = 0;
+        bool needsRender = false;
+        std::shared_ptr<const ImpulseResponseDisplay> latestResult;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Client)
+    };
+
+    ImpulseResponseRenderer();
+    ~ImpulseResponseRenderer() override;
+
+    static constexpr double renderSampleRate = 48000.0;
+    static constexpr double maximumLengthSeconds = 10.0;
+
+private:
+    void add (Client& client);
+    void remove (Client& client);
+    void request (Client& client, const ReverbSettings& settings);
+
+    void run() override;
+    void renderAndAnalyse (const ReverbSettings& settings);
+
+    // Renders into renderBuffer and returns the length kept, or zero if the
+    // render was abandoned.
+    int render (const ReverbSettings& settings, juce::uint64 hash);
+    bool isWanted (juce::uint64 hash) const;
+    void publish (std::shared_ptr<const ImpulseResponseDisplay> result, bool isComplete);
+
+    // Both called with the lock held.
+    std::shared_ptr<const ImpulseResponseDisplay> findCached (juce::uint64 hash);
+    void addToCache (std::shared_ptr<const ImpulseResponseDisplay> result);
+
+    static constexpr int debounceMs = 80;
+    static constexpr int renderBlockSize = 512;
+    static constexpr size_t cacheSize = 6;
+
+    struct CacheEntry
+    {
+        std::shared_ptr<const ImpulseResponseDisplay> result;
+        juce::uint32 lastUsed = 0;
+    };
+
+    juce::CriticalSection lock;
+    juce::Array<Client*> clients;
+    std::vector<CacheEntry> cache;
+    juce::uint32 cacheClock = 0;
+
+    // Render thread.
+    ReverbEngine engine;
+    SpectralEngine spectralEngine;
+    VelvetEngine velvetEngine;
+    DecayAnalyzer analyzer;
+    juce::AudioBuffer<float> renderBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ImpulseResponseRenderer)
+};
@@ -44,15 +44,18 @@ void KnobControl::resized()
     knob.setBounds (knobX, knobY, knobSize, knobSize);
     label.setBounds (bounds.getX(), knob.getBottom() + spacing, bounds.getWidth(), labelHeight);
     valueBox.setBounds (bounds.getX() + 8, label.getBottom() + spacing, bounds.getWidth() - 16, valueHeight);
+    valueBoxLayer.invalidate();
 }
 
 void KnobControl::paint (juce::Graphics& g)
 {
-    auto box = valueBox.getBounds().toFloat();
-    g.setColour (ObsidianStyle::panelFillDark());
-    g.fillRoundedRectangle (box, 6.0f);
-    g.setColour (ObsidianStyle::borderPurple());
-    g.drawRoundedRectangle (box, 6.0f, 1.0f);
+    valueBoxLayer.draw (g, valueBox.getBounds(), [box = valueBox.getLocalBounds().toFloat()] (juce::Graphics& layer)
+    {
+        layer.setColour (ObsidianStyle::panelFillDark());
+        layer.fillRoundedRectangle (box, 6.0f);
+        layer.setColour (ObsidianStyle::borderPurple());
+        layer.drawRoundedRectangle (box, 6.0f, 1.0f);
+    });
 }
 
 void KnobControl::updateValueText()
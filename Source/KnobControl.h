@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include "ObsidianSpaceLookAndFeel.h"
+#include "CachedLayer.h"
 
 class KnobControl : public juce::Component
 {
@@ -29,4 +30,7 @@ private:
     juce::Label label;
     juce::Label valueBox;
     Unit unit = Unit::None;
+
+    // Value box frame; the text is drawn by the label over it.
+    CachedLayer valueBoxLayer;
 };
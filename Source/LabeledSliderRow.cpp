@@ -41,15 +41,18 @@ void LabeledSliderRow::resized()
 
     bounds.removeFromTop (8);
     slider.setBounds (bounds.removeFromTop (22));
+    valueBoxLayer.invalidate();
 }
 
 void LabeledSliderRow::paint (juce::Graphics& g)
 {
-    auto box = valueBox.getBounds().toFloat();
-    g.setColour (ObsidianStyle::panelFillDark());
-    g.fillRoundedRectangle (box, 5.0f);
-    g.setColour (ObsidianStyle::borderPurple());
-    g.drawRoundedRectangle (box, 5.0f, 1.0f);
+    valueBoxLayer.draw (g, valueBox.getBounds(), [box = valueBox.getLocalBounds().toFloat()] (juce::Graphics& layer)
+    {
+        layer.setColour (ObsidianStyle::panelFillDark());
+        layer.fillRoundedRectangle (box, 5.0f);
+        layer.setColour (ObsidianStyle::borderPurple());
+        layer.drawRoundedRectangle (box, 5.0f, 1.0f);
+    });
 }
 
 void LabeledSliderRow::updateValueText()
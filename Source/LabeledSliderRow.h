@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include "ObsidianSpaceLookAndFeel.h"
+#include "CachedLayer.h"
 
 class LabeledSliderRow : public juce::Component
 {
@@ -27,4 +28,7 @@ private:
     juce::Label valueBox;
     juce::Slider slider;
     Unit unit = Unit::None;
+
+    // Value box frame; the text is drawn by the label over it.
+    CachedLayer valueBoxLayer;
 };
@@ -4,25 +4,35 @@ void ObsidianSpaceLookAndFeel::drawRotarySlider (juce::Graphics& g, int x, int y
                                                  float sliderPos, float rotaryStartAngle, float rotaryEndAngle,
                                                  juce::Slider& slider)
 {
-    auto bounds = juce::Rectangle<float> ((float) x, (float) y, (float) width, (float) height).reduced (3.0f);
-    auto radius = juce::jmin (bounds.getWidth(), bounds.getHeight()) * 0.5f;
-    auto centre = bounds.getCentre();
+    const auto area = juce::Rectangle<int> (x, y, width, height);
+    const auto isMouseOver = slider.isMouseOver();
 
-    if (slider.isMouseOver())
+    knobBodyLayers[isMouseOver ? 1 : 0].draw (g, area, [area, isMouseOver] (juce::Graphics& layer)
     {
-        g.setColour (ObsidianStyle::accentViolet().withAlpha (0.25f));
-        g.fillEllipse (bounds.expanded (3.0f));
-    }
-
-    juce::ColourGradient bodyGradient (juce::Colour::fromRGB (0x1b, 0x15, 0x24),
-                                       centre.x, centre.y - radius,
-                                       juce::Colour::fromRGB (0x0e, 0x0a, 0x14),
-                                       centre.x, centre.y + radius, false);
-    g.setGradientFill (bodyGradient);
-    g.fillEllipse (bounds);
-
-    g.setColour (juce::Colour::fromRGB (0x2b, 0x22, 0x36).withAlpha (0.8f));
-    g.drawEllipse (bounds, 1.0f);
+        auto body = area.withZeroOrigin().toFloat().reduced (3.0f);
+        auto bodyRadius = juce::jmin (body.getWidth(), body.getHeight()) * 0.5f;
+        auto bodyCentre = body.getCentre();
+
+        if (isMouseOver)
+        {
+            layer.setColour (ObsidianStyle::accentViolet().withAlpha (0.25f));
+            layer.fillEllipse (body.expanded (3.0f));
+        }
+
+        juce::ColourGradient bodyGradient (juce::Colour::fromRGB (0x1b, 0x15, 0x24),
+                                           bodyCentre.x, bodyCentre.y - bodyRadius,
+                                           juce::Colour::fromRGB (0x0e, 0x0a, 0x14),
+                                           bodyCentre.x, bodyCentre.y + bodyRadius, false);
+        layer.setGradientFill (bodyGradient);
+        layer.fillEllipse (body);
+
+        layer.setColour (juce::Colour::fromRGB (0x2b, 0x22, 0x36).withAlpha (0.8f));
+        layer.drawEllipse (body, 1.0f);
+    });
+
+    auto bounds = area.toFloat().reduced (3.0f);
+    auto radius = juce::jmin (bounds.getWidth(), bounds.getHeight()) * 0.5f;
+    auto centre = bounds.getCentre();
 
     auto angle = rotaryStartAngle + sliderPos * (rotaryEndAngle - rotaryStartAngle);
 
@@ -60,15 +70,19 @@ void ObsidianSpaceLookAndFeel::drawLinearSlider (juce::Graphics& g, int x, int y
     auto track = juce::Rectangle<float> (bounds.getX(), bounds.getCentreY() - trackHeight * 0.5f,
                                          bounds.getWidth(), trackHeight);
 
-    juce::ColourGradient trackGradient (juce::Colour::fromRGB (0x1b, 0x14, 0x24),
-                                        track.getX(), track.getY(),
-                                        juce::Colour::fromRGB (0x10, 0x0b, 0x18),
-                                        track.getRight(), track.getBottom(), false);
-    g.setGradientFill (trackGradient);
-    g.fillRoundedRectangle (track, trackHeight * 0.5f);
+    const auto trackArea = track.getSmallestIntegerContainer().expanded (1);
+    linearTrackLayer.draw (g, trackArea, [local = track - trackArea.getPosition().toFloat(), trackHeight] (juce::Graphics& layer)
+    {
+        juce::ColourGradient trackGradient (juce::Colour::fromRGB (0x1b, 0x14, 0x24),
+                                            local.getX(), local.getY(),
+                                            juce::Colour::fromRGB (0x10, 0x0b, 0x18),
+                                            local.getRight(), local.getBottom(), false);
+        layer.setGradientFill (trackGradient);
+        layer.fillRoundedRectangle (local, trackHeight * 0.5f);
 
-    g.setColour (ObsidianStyle::accentPurple().withAlpha (0.35f));
-    g.drawRoundedRectangle (track, trackHeight * 0.5f, 1.0f);
+        layer.setColour (ObsidianStyle::accentPurple().withAlpha (0.35f));
+        layer.drawRoundedRectangle (local, trackHeight * 0.5f, 1.0f);
+    });
 
     auto fill = track.withWidth (sliderPos - track.getX());
     juce::ColourGradient fillGradient (ObsidianStyle::accentPurple(),
@@ -91,3 +105,13 @@ void ObsidianSpaceLookAndFeel::drawLinearSlider (juce::Graphics& g, int x, int y
     g.setColour (ObsidianStyle::accentLight());
     g.fillEllipse (thumbCentre.x - thumbRadius, thumbCentre.y - thumbRadius, thumbRadius * 2.0f, thumbRadius * 2.0f);
 }
+
+void ObsidianSpaceLookAndFeel::drawPanel (juce::Graphics& g, juce::Rectangle<float> bounds)
+{
+    g.setColour (ObsidianStyle::panelFill());
+    g.fillRoundedRectangle (bounds, 12.0f);
+    g.setColour (ObsidianStyle::panelOverlay());
+    g.fillRoundedRectangle (bounds, 12.0f);
+    g.setColour (ObsidianStyle::borderPurple());
+    g.drawRoundedRectangle (bounds, 12.0f, 1.0f);
+}
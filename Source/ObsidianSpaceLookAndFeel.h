@@ -1,6 +1,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "CachedLayer.h"
 
 namespace ObsidianStyle
 {
@@ -31,4 +32,13 @@ public:
     void drawLinearSlider (juce::Graphics& g, int x, int y, int width, int height,
                            float sliderPos, float minSliderPos, float maxSliderPos,
                            const juce::Slider::SliderStyle style, juce::Slider& slider) override;
+
+    // The rounded, outlined panel used behind grouped controls.
+    static void drawPanel (juce::Graphics& g, juce::Rectangle<float> bounds);
+
+private:
+    // Static parts of the sliders, shared by every slider of the same size.
+    // Only the value arc, pointer, fill and thumb are drawn per repaint.
+    std::array<CachedLayer, 2> knobBodyLayers; // indexed by mouse-over
+    CachedLayer linearTrackLayer;
 };
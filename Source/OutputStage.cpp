@@ -0,0 +1,104 @@
+#include "OutputStage.h"
+
+void OutputStage::prepare (double sampleRate, int numChannels)
+{
+    jassert (sampleRate > 0.0);
+    jassert (numChannels > 0 && numChannels <= maximumChannels);
+    juce::ignoreUnused (numChannels);
+
+    currentSampleRate = sampleRate;
+    lowCutCoefficient = getCoefficient (lowCutHz, sampleRate);
+    highCutCoefficient = getCoefficient (highCutHz, sampleRate);
+    dryGain.reset (sampleRate, 0.01);
+    reset();
+}
+
+void OutputStage::reset() noexcept
+{
+    lowCutState.fill (0.0f);
+    highCutState.fill (0.0f);
+    dryGain.setCurrentAndTargetValue (dryGain.getTargetValue());
+}
+
+void OutputStage::setCutoffs (float newLowCutHz, float newHighCutHz) noexcept
+{
+    if (newLowCutHz != lowCutHz)
+    {
+        lowCutHz = newLowCutHz;
+        lowCutCoefficient = getCoefficient (lowCutHz, currentSampleRate);
+    }
+
+    if (newHighCutHz != highCutHz)
+    {
+        highCutHz = newHighCutHz;
+        highCutCoefficient = getCoefficient (highCutHz, currentSampleRate);
+    }
+}
+
+float OutputStage::getCoefficient (float cutoffHz, double sampleRate) noexcept
+{
+    // g / (1 + g) with g = tan (pi fc / fs), kept below Nyquist.
+    const auto cutoff = juce::jlimit (1.0, sampleRate * 0.49, (double) cutoffHz);
+    const auto g = std::tan (juce::MathConstants<double>::pi * cutoff / sampleRate);
+    return (float) (g / (1.0 + g));
+}
+
+void OutputStage::process (float* const* wet, const float* const* dry, int numChannels, int numSamples,
+                           float* const* filteredWet) noexcept
+{
+    if (numChannels == 2)
+    {
+        if (filteredWet != nullptr)
+            processChannels<2, true> (wet, dry, filteredWet, numSamples);
+        else
+            processChannels<2, false> (wet, dry, filteredWet, numSamples);
+    }
+    else if (numChannels == 1)
+    {
+        if (filteredWet != nullptr)
+            processChannels<1, true> (wet, dry, filteredWet, numSamples);
+        else
+            processChannels<1, false> (wet, dry, filteredWet, numSamples);
+    }
+    else
+    {
+        jassert (numChannels == 0); // only mono and stereo layouts are supported
+    }
+}
+
+template <int numChannels, bool tapWet>
+void OutputStage::processChannels (float* const* wet, const float* const* dry, float* const* filteredWet, int numSamples) noexcept
+{
+    const auto lowCut = lowCutCoefficient;
+    const auto highCut = highCutCoefficient;
+    auto lowState = lowCutState;
+    auto highState = highCutState;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto gain = dryGain.getNextValue();
+
+        for (size_t channel = 0; channel < (size_t) numChannels; ++channel)
+        {
+            const auto input = wet[channel][i];
+
+            // The low-cut is the input minus a low-pass at its cutoff.
+            const auto lowV = (input - lowState[channel]) * lowCut;
+            const auto lowPassed = lowV + lowState[channel];
+            lowState[channel] = lowPassed + lowV;
+            const auto highPassed = input - lowPassed;
+
+            const auto highV = (highPassed - highState[channel]) * highCut;
+            const auto output = highV + highState[channel];
+            highState[channel] = output + highV;
+
+            if constexpr (tapWet)
+                filteredWet[channel][i] = output;
+
+            wet[channel][i] = output + dry[channel][i] * gain;
+        }
+    }
+
+    lowCutState = lowState;
+    highCutState = highState;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// The last pass over each block: the wet signal through the LOWCUT high-pass
+// and HIGHCUT low-pass, plus the dry signal at its smoothed gain. Both
+// filters and the mix run in one loop, so each output sample is loaded and
+// stored once, however many stages there are. Width and the wet gains are
+// applied earlier, inside each engine's own chunk loop.
+//
+// The filters are one-pole, in the topology-preserving form so cutoff
+// changes never click. Their recursion runs sample by sample, so the loop
+// keeps both channels in one pass for two independent chains to overlap,
+// rather than trying to vectorise across time.
+class OutputStage
+{
+public:
+    void prepare (double sampleRate, int numChannels);
+
+    // Clears the filters and jumps the dry gain to its target.
+    void reset() noexcept;
+
+    // Audio thread, once per block. Only recomputes coefficients that moved.
+    void setCutoffs (float lowCutHz, float highCutHz) noexcept;
+    void setDryGain (float newGain) noexcept { dryGain.setTargetValue (newGain); }
+
+    // wet holds the wet signal and is replaced with the output. If filteredWet
+    // is given, it also receives the wet signal after the filters, before the
+    // dry signal is added.
+    void process (float* const* wet, const float* const* dry, int numChannels, int numSamples,
+                  float* const* filteredWet = nullptr) noexcept;
+
+private:
+    template <int numChannels, bool tapWet>
+    void processChannels (float* const* wet, const float* const* dry, float* const* filteredWet, int numSamples) noexcept;
+
+    static float getCoefficient (float cutoffHz, double sampleRate) noexcept;
+
+    static constexpr int maximumChannels = 2;
+
+    double currentSampleRate = 44100.0;
+    float lowCutHz = 20.0f, highCutHz = 20000.0f;
+    float lowCutCoefficient = 0.0f, highCutCoefficient = 1.0f;
+    std::array<float, (size_t) maximumChannels> lowCutState {}, highCutState {};
+    juce::SmoothedValue<float> dryGain;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OutputStage)
+};
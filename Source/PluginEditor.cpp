@@ -45,17 +45,15 @@ void SliderPanel::resized()
     firstRow.setBounds (bounds.removeFromTop (rowHeight));
     bounds.removeFromTop (16);
     secondRow.setBounds (bounds.removeFromTop (rowHeight));
+    panelLayer.invalidate();
 }
 
 void SliderPanel::paint (juce::Graphics& g)
 {
-    auto bounds = getLocalBounds().toFloat();
-    g.setColour (ObsidianStyle::panelFill());
-    g.fillRoundedRectangle (bounds, 12.0f);
-    g.setColour (ObsidianStyle::panelOverlay());
-    g.fillRoundedRectangle (bounds, 12.0f);
-    g.setColour (ObsidianStyle::borderPurple());
-    g.drawRoundedRectangle (bounds, 12.0f, 1.0f);
+    panelLayer.draw (g, getLocalBounds(), [bounds = getLocalBounds().toFloat()] (juce::Graphics& layer)
+    {
+        ObsidianSpaceLookAndFeel::drawPanel (layer, bounds);
+    });
 }
 
 //==============================================================================
@@ -63,8 +61,10 @@ ObsidianSpaceAudioProcessorEditor::ObsidianSpaceAudioProcessorEditor (ObsidianSp
     : AudioProcessorEditor (&p),
       audioProcessor (p),
       lookAndFeel(),
+      impulseResponses(),
       header(),
-      visualizer (p.roomSizeParam, p.decayParam, p.dampingParam),
+      visualizer (p.apvts, impulseResponses, &p.getWetSignalFifo()),
+      decayAnalyzer (impulseResponses),
       footer(),
       roomSizeKnob ("ROOM SIZE", KnobControl::Unit::Percent),
       decayKnob ("DECAY", KnobControl::Unit::Seconds),
@@ -80,6 +80,7 @@ ObsidianSpaceAudioProcessorEditor::ObsidianSpaceAudioProcessorEditor (ObsidianSp
 
     addAndMakeVisible (header);
     addAndMakeVisible (visualizer);
+    addAndMakeVisible (decayAnalyzer);
     addAndMakeVisible (roomSizeKnob);
     addAndMakeVisible (decayKnob);
     addAndMakeVisible (preDelayKnob);
@@ -89,6 +90,8 @@ ObsidianSpaceAudioProcessorEditor::ObsidianSpaceAudioProcessorEditor (ObsidianSp
     addAndMakeVisible (footer);
 
     footer.setPowerParam (audioProcessor.powerParam);
+    footer.setLoadMeter (&audioProcessor.getLoadMeter());
+    footer.setQualityController (&audioProcessor.getQualityController());
     header.getPowerButton().onClick = [this] { footer.repaint(); };
 
     roomSizeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment> (audioProcessor.apvts, "ROOMSIZE", roomSizeKnob.getSlider());
@@ -118,16 +121,10 @@ void ObsidianSpaceAudioProcessorEditor::paint (juce::Graphics& g)
     g.setGradientFill (background);
     g.fillAll();
 
-    if (! knobRowBounds.isEmpty())
+    knobRowLayer.draw (g, knobRowBounds, [row = knobRowBounds.withZeroOrigin().toFloat()] (juce::Graphics& layer)
     {
-        auto row = knobRowBounds.toFloat();
-        g.setColour (ObsidianStyle::panelFill());
-        g.fillRoundedRectangle (row, 12.0f);
-        g.setColour (ObsidianStyle::panelOverlay());
-        g.fillRoundedRectangle (row, 12.0f);
-        g.setColour (ObsidianStyle::borderPurple());
-        g.drawRoundedRectangle (row, 12.0f, 1.0f);
-    }
+        ObsidianSpaceLookAndFeel::drawPanel (layer, row);
+    });
 }
 
 void ObsidianSpaceAudioProcessorEditor::resized()
@@ -147,10 +144,15 @@ void ObsidianSpaceAudioProcessorEditor::resized()
 
     auto content = bounds.reduced (contentPadding);
     auto vizArea = content.removeFromTop (visualizerHeight);
+    const int analyzerWidth = 360;
+    const int analyzerGap = 24;
+    decayAnalyzer.setBounds (vizArea.removeFromRight (analyzerWidth));
+    vizArea.removeFromRight (analyzerGap);
     visualizer.setBounds (vizArea);
     content.removeFromTop (sectionGap);
 
     knobRowBounds = content.removeFromTop (knobRowHeight);
+    knobRowLayer.invalidate();
     const int knobSize = 90;
     const int gap = 40;
     const int totalWidth = knobSize * 4 + gap * 3;
@@ -14,8 +14,10 @@
 #include "HeaderComponent.h"
 #include "FooterComponent.h"
 #include "VisualizerComponent.h"
+#include "DecayAnalyzerComponent.h"
 #include "KnobControl.h"
 #include "LabeledSliderRow.h"
+#include "CachedLayer.h"
 
 class SliderPanel : public juce::Component
 {
@@ -34,6 +36,7 @@ private:
     juce::Label titleLabel;
     LabeledSliderRow firstRow;
     LabeledSliderRow secondRow;
+    CachedLayer panelLayer;
 };
 
 //==============================================================================
@@ -53,8 +56,10 @@ private:
     ObsidianSpaceAudioProcessor& audioProcessor;
 
     ObsidianSpaceLookAndFeel lookAndFeel;
+    ImpulseResponseRenderer::Client impulseResponses;
     HeaderComponent header;
     VisualizerComponent visualizer;
+    DecayAnalyzerComponent decayAnalyzer;
     FooterComponent footer;
 
     KnobControl roomSizeKnob;
@@ -65,7 +70,10 @@ private:
     SliderPanel outputPanel;
     SliderPanel tonePanel;
 
+    // The window gradient is filled directly: at full size a cached copy
+    // would cost as much to blit as the gradient does to fill.
     juce::Rectangle<int> knobRowBounds;
+    CachedLayer knobRowLayer;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> roomSizeAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> decayAttachment;
@@ -7,7 +7,10 @@
 */
 
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
+
+#if ! OBSIDIAN_HEADLESS
+ #include "PluginEditor.h"
+#endif
 #include <cmath>
 
 //==============================================================================
@@ -33,19 +36,51 @@ ObsidianSpaceAudioProcessor::ObsidianSpaceAudioProcessor()
     lowCutParam = apvts.getRawParameterValue ("LOWCUT");
     highCutParam = apvts.getRawParameterValue ("HIGHCUT");
     powerParam = apvts.getRawParameterValue ("POWER");
+    freezeParam = apvts.getRawParameterValue ("FREEZE");
+    busModeParam = apvts.getRawParameterValue ("BUSMODE");
+    busIdParam = apvts.getRawParameterValue ("BUSID");
+    engineParam = apvts.getRawParameterValue ("ENGINE");
+    pipelineParam = apvts.getRawParameterValue ("PIPELINE");
+    qualityBudgetParam = apvts.getRawParameterValue ("QUALITYBUDGET");
+
+    apvts.addParameterListener ("BUSMODE", this);
+    apvts.addParameterListener ("BUSID", this);
+    apvts.addParameterListener ("ROOMSIZE", this);
+    apvts.addParameterListener ("DECAY", this);
+    apvts.addParameterListener ("PIPELINE", this);
+    apvts.addParameterListener ("QUALITYBUDGET", this);
     
     // Initialize reverb parameters with default values
     reverbParams.roomSize = 0.5f;
     reverbParams.damping = 0.5f;
     reverbParams.wetLevel = 0.3f;
-    reverbParams.dryLevel = 0.7f;
+    reverbParams.dryLevel = 0.0f;
     reverbParams.width = 1.0f;
     reverbParams.freezeMode = false;
-    reverb.setParameters (reverbParams);
+
+    for (auto& engine : engines)
+        engine.setParameters (reverbParams);
+
+    spectralEngine.setParameters (getSpectralParameters());
+    velvetEngine.setParameters (getVelvetParameters());
+    outputStage.setDryGain (0.7f * dryScaleFactor);
+    outputStage.reset();
+
+    startTimer (timerIntervalMs);
 }
 
 ObsidianSpaceAudioProcessor::~ObsidianSpaceAudioProcessor()
 {
+    dspAllocator->remove (*this);
+    pipeline.stop();
+    stopTimer();
+    apvts.removeParameterListener ("BUSMODE", this);
+    apvts.removeParameterListener ("BUSID", this);
+    apvts.removeParameterListener ("ROOMSIZE", this);
+    apvts.removeParameterListener ("DECAY", this);
+    apvts.removeParameterListener ("PIPELINE", this);
+    apvts.removeParameterListener ("QUALITYBUDGET", this);
+    leaveBus();
 }
 
 //==============================================================================
@@ -83,50 +118,275 @@ bool ObsidianSpaceAudioProcessor::isMidiEffect() const
 
 double ObsidianSpaceAudioProcessor::getTailLengthSeconds() const
 {
+    // The spectral engine's longest decay is stretched by the largest room.
+    if (getEngineType() == EngineType::spectral)
+        return 10.0 * SpectralEngine::maximumRoomScale;
+
     return 10.0; // Long tail for reverb
 }
 
 int ObsidianSpaceAudioProcessor::getNumPrograms()
 {
-    return 1;
+    return FactoryPresets::getNumPresets();
 }
 
 int ObsidianSpaceAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram.load();
 }
 
 void ObsidianSpaceAudioProcessor::setCurrentProgram (int index)
 {
+    if (! juce::isPositiveAndBelow (index, getNumPrograms()))
+        return;
+
+    currentProgram = index;
+
+    // A crossfade is still running; take the latest request once it ends.
+    queuedProgram = beginProgramSwitch (index) ? -1 : index;
 }
 
 const juce::String ObsidianSpaceAudioProcessor::getProgramName (int index)
 {
-    return {};
+    if (! juce::isPositiveAndBelow (index, getNumPrograms()))
+        return {};
+
+    return FactoryPresets::get (index).name;
 }
 
 void ObsidianSpaceAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    // Factory presets are read-only.
+    juce::ignoreUnused (index, newName);
+}
+
+bool ObsidianSpaceAudioProcessor::beginProgramSwitch (int index)
+{
+    const auto& preset = FactoryPresets::get (index);
+
+    // Without engines there is nothing to crossfade; they pick the preset
+    // up from the parameters once allocated.
+    if (! isPrepared.load() || ! isAllocated())
+    {
+        preset.settings.applyTo (apvts);
+        return true;
+    }
+
+    auto expected = ProgramSwitch::idle;
+    if (! programSwitch.compare_exchange_strong (expected, ProgramSwitch::preparing, std::memory_order_acquire))
+        return false;
+
+    // The audio thread holds its parameters while this is preparing, so the
+    // playing engine never sees the new values and swaps to the standby one
+    // already configured for them.
+    auto& standby = getStandbyEngine();
+    standby.setParameters (preset.settings.toReverbParameters());
+    standby.reset();
+    preset.settings.applyTo (apvts);
+
+    programSwitch.store (ProgramSwitch::ready, std::memory_order_release);
+    return true;
+}
+
+void ObsidianSpaceAudioProcessor::timerCallback()
+{
+    if (queuedProgram >= 0 && beginProgramSwitch (queuedProgram))
+        queuedProgram = -1;
+
+    if (settingsChanged.exchange (false))
+        applySettingChanges();
 }
 
 //==============================================================================
 void ObsidianSpaceAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+    const auto numChannels = getTotalNumOutputChannels();
+
+    // The worker must be idle before anything it processes is touched, and
+    // so must the allocator.
+    pipeline.stop();
+    dspAllocator->remove (*this);
+
+    // Hosts re-prepare on transport start, bounces and device changes; with
+    // nothing changed there is nothing to do, unless a bounce is starting
+    // before any signal arrived.
+    if (sampleRate == currentSampleRate && samplesPerBlock == preparedBlockSize && numChannels == preparedNumChannels)
+    {
+        if (isNonRealtime() && ! isAllocated())
+        {
+            allocateNow();
+            wetFadeIn.setCurrentAndTargetValue (1.0f);
+        }
+
+        updatePipeline (sampleRate, samplesPerBlock, numChannels);
+        isPrepared = true;
+        dspAllocator->add (*this);
+        return;
+    }
+
     currentSampleRate = sampleRate;
-    
+    preparedBlockSize = samplesPerBlock;
+    preparedNumChannels = numChannels;
+
+    loadMeter.prepare (sampleRate);
+    qualityController.prepare (sampleRate);
+   #if OBSIDIAN_ENABLE_PROFILING
+    profiler.prepare (sampleRate);
+    workerProfiler.prepare (sampleRate);
+   #endif
+
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = static_cast<juce::uint32> (samplesPerBlock);
-    spec.numChannels = static_cast<juce::uint32> (getTotalNumOutputChannels());
-    
-    reverb.prepare (spec);
+    spec.numChannels = static_cast<juce::uint32> (numChannels);
+    preparedSpec = spec;
+
+    if (isAllocated())
+        prepareEngines (spec);
+    else if (isNonRealtime())
+        allocateNow();
+
+    programFadeLength = juce::jmax (1, juce::roundToInt (sampleRate * programFadeSeconds));
+    resetEngines();
+    fadeBuffer.setSize (numChannels, samplesPerBlock, false, false, true);
+    dryBuffer.setSize (numChannels, samplesPerBlock, false, false, true);
+    filteredWetBuffer.setSize (numChannels, samplesPerBlock, false, false, true);
+
+    leaveBus();
+    busSend.prepare (samplesPerBlock);
+    updateBusMembership();
+    outputStage.prepare (sampleRate, numChannels);
+    wetSignalFifo.prepare (sampleRate);
+    wetFadeIn.reset (sampleRate, wetFadeInSeconds);
+    wetFadeIn.setCurrentAndTargetValue (isAllocated() ? 1.0f : 0.0f);
     
     updateParameters();
+    updatePipeline (sampleRate, samplesPerBlock, numChannels);
+    isPrepared = true;
+    dspAllocator->add (*this);
 }
 
 void ObsidianSpaceAudioProcessor::releaseResources()
 {
-    reverb.reset();
+    pipeline.stop();
+    dspAllocator->remove (*this);
+    isPrepared = false;
+    resetEngines();
+}
+
+void ObsidianSpaceAudioProcessor::prepareEngines (const juce::dsp::ProcessSpec& spec)
+{
+    // Allocates on the first call only; a new rate just retunes the lines.
+    for (auto& engine : engines)
+        engine.prepare (spec);
+
+    spectralEngine.prepare (spec);
+
+    velvetEngine.requestTables (decayParam->load(), ReverbSettings::normaliseRoomSize (roomSizeParam->load()));
+    velvetEngine.prepare (spec);
+
+    freezeLooper.prepare (spec.sampleRate, (int) spec.numChannels);
+}
+
+void ObsidianSpaceAudioProcessor::allocate()
+{
+    prepareEngines (preparedSpec);
+}
+
+void ObsidianSpaceAudioProcessor::allocationFinished()
+{
+    // Picks up any DECAY or ROOMSIZE change the velvet engine missed while
+    // it was being prepared.
+    settingsChanged.store (true);
+}
+
+void ObsidianSpaceAudioProcessor::requestAllocationIfAudible (const juce::dsp::AudioBlock<float>& block, bool allocateOnThisThread)
+{
+    if (isAllocated())
+        return;
+
+    // Roughly -90 dBFS; dither and denormal noise stay below it.
+    const auto silenceThreshold = 3.0e-5f;
+    const auto range = block.findMinAndMax();
+
+    if (juce::jmax (-range.getStart(), range.getEnd()) <= silenceThreshold)
+        return;
+
+    // A bounce that started before any signal allocates right here, and
+    // keeps the start of the tail, rather than waiting for the allocator's
+    // next poll.
+    if (allocateOnThisThread)
+        allocateNowOrWait();
+    else
+        requestAllocation();
+}
+
+bool ObsidianSpaceAudioProcessor::isPipelineRequested() const noexcept
+{
+    return pipelineParam != nullptr && pipelineParam->load() > 0.5f;
+}
+
+void ObsidianSpaceAudioProcessor::updatePipeline (double sampleRate, int samplesPerBlock, int numChannels)
+{
+    isPipelined = isPipelineRequested();
+
+    if (isPipelined)
+    {
+        dryDelay.setMaximumDelayInSamples (samplesPerBlock);
+        dryDelay.prepare ({ sampleRate, (juce::uint32) samplesPerBlock, (juce::uint32) numChannels });
+        dryDelay.setDelay ((float) samplesPerBlock);
+        pipeline.start (sampleRate, samplesPerBlock, numChannels);
+    }
+
+    setLatencySamples (isPipelined ? pipeline.getLatencySamples() : 0);
+}
+
+void ObsidianSpaceAudioProcessor::delayDrySignal (juce::AudioBuffer<float>& buffer, int numChannels, int numSamples)
+{
+    if (! isPipelined)
+        return;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* samples = buffer.getWritePointer (channel);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            dryDelay.pushSample (channel, samples[i]);
+            samples[i] = dryDelay.popSample (channel);
+        }
+    }
+}
+
+void ObsidianSpaceAudioProcessor::resetWet()
+{
+    resetEngines();
+}
+
+void ObsidianSpaceAudioProcessor::resetEngines()
+{
+    engineLevels.fill (0);
+    engineLevels[(size_t) currentEngineType] = programFadeLength;
+
+    // Nothing to clear yet, and the allocator may be preparing them.
+    if (! isAllocated())
+        return;
+
+    getActiveEngine().reset();
+    spectralEngine.reset();
+    velvetEngine.reset();
+    freezeLooper.reset();
+
+    // The standby engine is only ours to touch while it is fading out.
+    if (programSwitch.load (std::memory_order_acquire) == ProgramSwitch::fading)
+        endProgramCrossfade();
+}
+
+void ObsidianSpaceAudioProcessor::endProgramCrossfade()
+{
+    getStandbyEngine().reset();
+    programFadeRemaining = 0;
+    programSwitch.store (ProgramSwitch::idle, std::memory_order_release);
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -153,60 +413,483 @@ void ObsidianSpaceAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
 {
     juce::ignoreUnused (midiMessages);
     
+    const auto numSamples = buffer.getNumSamples();
+    DspLoadMeter::ScopedTimer loadTimer (loadMeter, numSamples);
+    OBSIDIAN_PROFILE_STAGE (profiler, DspStage::block, numSamples);
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+        buffer.clear (i, 0, numSamples);
+
+    const auto numChannels = juce::jmin (buffer.getNumChannels(), totalNumOutputChannels);
+    const auto isOffline = isNonRealtime();
+    isRenderingOffline.store (isOffline, std::memory_order_relaxed);
+
+    // Working buffers hold one prepared block, so a host sending more runs
+    // in pieces rather than growing them here.
+    if (preparedBlockSize <= 0 || numChannels > dryBuffer.getNumChannels())
+    {
+        jassertfalse; // processBlock before prepareToPlay
+        return;
+    }
+
+    for (int start = 0; start < numSamples; start += preparedBlockSize)
+    {
+        juce::AudioBuffer<float> subBlock (buffer.getArrayOfWritePointers(), numChannels, start,
+                                           juce::jmin (preparedBlockSize, numSamples - start));
+        processSubBlock (subBlock, numChannels, isOffline);
+    }
+}
+
+void ObsidianSpaceAudioProcessor::processSubBlock (juce::AudioBuffer<float>& buffer, int numChannels, bool isOffline)
+{
+    const auto numSamples = buffer.getNumSamples();
+    jassert (numSamples <= dryBuffer.getNumSamples());
 
     const bool isPowered = powerParam == nullptr || powerParam->load() > 0.5f;
     if (isPowered != cachedPower)
     {
         cachedPower = isPowered;
         if (! isPowered)
-            reverb.reset();
+        {
+            // The worker owns the engines while pipelining.
+            if (isPipelined)
+                pipeline.reset();
+            else
+                resetEngines();
+
+            outputStage.reset();
+        }
     }
 
+    // Audio passing through still carries the latency reported to the host.
     if (! isPowered)
+    {
+        delayDrySignal (buffer, numChannels, numSamples);
         return;
+    }
 
-    updateParameters();
+    if (getBusMode() == BusMode::send)
+    {
+        const auto sendGain = ReverbSettings::normaliseMix (mixParam->load());
+        busSend.push (buffer, numChannels, numSamples, lastSendGain, sendGain);
+        lastSendGain = sendGain;
+        delayDrySignal (buffer, numChannels, numSamples);
+        return;
+    }
+
+    lastSendGain = 0.0f;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        dryBuffer.copyFrom (channel, 0, buffer, channel, 0, numSamples);
+
+    delayDrySignal (dryBuffer, numChannels, numSamples);
+
+    if (auto* bus = receivingBus.load (std::memory_order_acquire))
+        bus->addSendsTo (buffer, numChannels, numSamples);
 
     // Process audio
     juce::dsp::AudioBlock<float> block (buffer);
-    juce::dsp::ProcessContextReplacing<float> context (block);
-    
+    block = block.getSubsetChannelBlock (0, (size_t) numChannels);
+    requestAllocationIfAudible (block, isOffline);
+
+    if (isPipelined)
+    {
+        OBSIDIAN_PROFILE_STAGE (profiler, DspStage::pipelineHandoff, numSamples);
+        pipeline.process (buffer, numChannels, numSamples, isOffline);
+    }
+    else
+    {
+        processWet (block, numChannels, numSamples);
+    }
+
+    // The visualizer shows the wet signal as heard, so it is tapped after the
+    // tone filters but before the dry signal joins it.
+    const auto isShowingWet = wetSignalFifo.isActive();
+    jassert (numSamples <= filteredWetBuffer.getNumSamples() && numChannels <= filteredWetBuffer.getNumChannels());
+
+    {
+        OBSIDIAN_PROFILE_STAGE (profiler, DspStage::outputMix, numSamples);
+        outputStage.setCutoffs (lowCutParam->load(), highCutParam->load());
+        outputStage.setDryGain ((1.0f - ReverbSettings::normaliseMix (mixParam->load())) * dryScaleFactor);
+        outputStage.process (buffer.getArrayOfWritePointers(), dryBuffer.getArrayOfReadPointers(), numChannels, numSamples,
+                             isShowingWet ? filteredWetBuffer.getArrayOfWritePointers() : nullptr);
+    }
+
+    if (isShowingWet)
+    {
+        juce::dsp::AudioBlock<float> filteredWet (filteredWetBuffer);
+        wetSignalFifo.pushBlock (filteredWet.getSubBlock (0, (size_t) numSamples)
+                                            .getSubsetChannelBlock (0, (size_t) numChannels));
+    }
+}
+
+// Everything the engines touch, so it can run on the pipeline worker.
+void ObsidianSpaceAudioProcessor::processWet (juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples)
+{
+   #if OBSIDIAN_ENABLE_PROFILING
+    auto& wetProfiler = isPipelined ? workerProfiler : profiler;
+   #endif
+
+    if (! isAllocated())
+    {
+        block.clear();
+        wetFadeIn.setCurrentAndTargetValue (0.0f);
+        return;
+    }
+
+    wetFadeIn.setTargetValue (1.0f);
+
+    {
+        OBSIDIAN_PROFILE_STAGE (wetProfiler, DspStage::parameterUpdate, numSamples);
+        const auto switchState = programSwitch.load (std::memory_order_acquire);
+
+        const auto isSwapping = switchState == ProgramSwitch::ready;
+
+        if (isSwapping)
+        {
+            activeEngine.store (1 - activeEngine.load (std::memory_order_relaxed), std::memory_order_relaxed);
+            programFadeRemaining = programFadeLength;
+            programSwitch.store (ProgramSwitch::fading, std::memory_order_relaxed);
+        }
+
+        if (switchState != ProgramSwitch::preparing)
+            updateParameters();
+
+        // The incoming engine was configured from the preset alone, which
+        // knows nothing about freeze.
+        if (isSwapping)
+            getActiveEngine().setParameters (reverbParams);
+
+        // Judged on the previous block, since this one hasn't run yet. On
+        // the worker that is its own previous chunk. Offline there is no
+        // deadline, and playback afterwards starts from a clean slate. Only
+        // the classic network has a cheaper tier, so with the spectral or
+        // velvet engine the controller stays at full quality rather than
+        // report a reduction that never happens.
+        auto quality = QualityController::Level::full;
+
+        if (isRenderingOffline.load (std::memory_order_relaxed) || getEngineType() != EngineType::classic)
+            qualityController.reset();
+        else if (isPipelined)
+            quality = qualityController.update (pipeline.getLastChunkLoad(), pipeline.getLastChunkSize());
+        else
+            quality = qualityController.update (loadMeter.getLastBlockLoad(), loadMeter.getLastBlockSize());
+
+        getActiveEngine().setNetworkSize (quality == QualityController::Level::full ? ReverbEngine::NetworkSize::full
+                                                                                    : ReverbEngine::NetworkSize::reduced);
+
+        const auto engineType = getEngineType();
+        if (engineType != currentEngineType)
+        {
+            currentEngineType = engineType;
+
+            // A cleared engine starts from silence, so it needs no fade in.
+            auto& level = engineLevels[(size_t) engineType];
+            if (level == 0)
+                level = programFadeLength;
+        }
+
+        // Only the classic engine has a standby, so away from it a program
+        // change lands at once.
+        if (currentEngineType != EngineType::classic && programFadeRemaining > 0)
+            endProgramCrossfade();
+
+        freezeLooper.setFrozen (cachedFreeze);
+    }
+
     // Process reverb
-    reverb.process (context);
+    {
+        OBSIDIAN_PROFILE_STAGE (wetProfiler, DspStage::reverbTail, numSamples);
+
+        // While the frozen loop plays on its own the engines sit idle.
+        if (freezeLooper.needsEngine())
+        {
+            processActiveEngine (block, numChannels, numSamples);
+
+            if (engineLevels[(size_t) currentEngineType] < programFadeLength)
+                fadeInActiveEngine (block, numChannels, numSamples);
+
+            for (int type = 0; type < numEngineTypes; ++type)
+                if ((EngineType) type != currentEngineType && engineLevels[(size_t) type] > 0)
+                    ringOutEngine ((EngineType) type, block, numChannels, numSamples);
+        }
+
+        freezeLooper.process (block, reverbParams.wetLevel);
+
+        if (wetFadeIn.isSmoothing())
+            block.multiplyBy (wetFadeIn);
+    }
+}
+
+void ObsidianSpaceAudioProcessor::processEngine (EngineType type, juce::dsp::ProcessContextReplacing<float>& context)
+{
+    switch (type)
+    {
+        case EngineType::spectral:  spectralEngine.process (context); break;
+        case EngineType::velvet:    velvetEngine.process (context); break;
+        case EngineType::classic:   getActiveEngine().process (context); break;
+    }
+}
+
+void ObsidianSpaceAudioProcessor::processActiveEngine (juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples)
+{
+    if (currentEngineType == EngineType::classic && programFadeRemaining > 0)
+    {
+        processProgramCrossfade (block, numChannels, numSamples);
+        return;
+    }
+
+    juce::dsp::ProcessContextReplacing<float> context (block);
+    processEngine (currentEngineType, context);
+}
+
+void ObsidianSpaceAudioProcessor::fadeInActiveEngine (juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples)
+{
+    auto& level = engineLevels[(size_t) currentEngineType];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto gain = (float) level / (float) programFadeLength;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            block.getChannelPointer ((size_t) channel)[i] *= gain;
+
+        if (level < programFadeLength)
+            ++level;
+    }
+}
+
+void ObsidianSpaceAudioProcessor::ringOutEngine (EngineType type, juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples)
+{
+    // processBlock and the pipeline never pass more than a prepared block.
+    jassert (numSamples <= fadeBuffer.getNumSamples() && numChannels <= fadeBuffer.getNumChannels());
+
+    auto outgoing = juce::dsp::AudioBlock<float> (fadeBuffer)
+                        .getSubsetChannelBlock (0, (size_t) numChannels)
+                        .getSubBlock (0, (size_t) numSamples);
+    outgoing.clear();
+
+    juce::dsp::ProcessContextReplacing<float> outgoingContext (outgoing);
+    processEngine (type, outgoingContext);
+
+    auto& level = engineLevels[(size_t) type];
+
+    for (int i = 0; i < numSamples && level > 0; ++i)
+    {
+        const auto gain = (float) level / (float) programFadeLength;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            block.getChannelPointer ((size_t) channel)[i] += outgoing.getSample (channel, i) * gain;
+
+        --level;
+    }
+
+    if (level == 0)
+        resetEngine (type);
+}
+
+void ObsidianSpaceAudioProcessor::resetEngine (EngineType type)
+{
+    switch (type)
+    {
+        case EngineType::spectral:  spectralEngine.reset(); break;
+        case EngineType::velvet:    velvetEngine.reset(); break;
+        case EngineType::classic:   getActiveEngine().reset(); break;
+    }
+}
+
+void ObsidianSpaceAudioProcessor::processProgramCrossfade (juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples)
+{
+    // processBlock and the pipeline never pass more than a prepared block.
+    jassert (numSamples <= fadeBuffer.getNumSamples() && numChannels <= fadeBuffer.getNumChannels());
+
+    // The outgoing engine gets silence and rings out under the incoming one.
+    auto outgoing = juce::dsp::AudioBlock<float> (fadeBuffer)
+                        .getSubsetChannelBlock (0, (size_t) numChannels)
+                        .getSubBlock (0, (size_t) numSamples);
+    outgoing.clear();
+
+    juce::dsp::ProcessContextReplacing<float> outgoingContext (outgoing);
+    getStandbyEngine().process (outgoingContext);
+
+    juce::dsp::ProcessContextReplacing<float> incomingContext (block);
+    getActiveEngine().process (incomingContext);
+
+    // Equal-power fade; the two tails are uncorrelated.
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto progress = 1.0f - (float) programFadeRemaining / (float) programFadeLength;
+        const auto incomingGain = std::sqrt (progress);
+        const auto outgoingGain = std::sqrt (1.0f - progress);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* incoming = block.getChannelPointer ((size_t) channel);
+            incoming[i] = incoming[i] * incomingGain + outgoing.getSample (channel, i) * outgoingGain;
+        }
+
+        if (programFadeRemaining > 0)
+            --programFadeRemaining;
+    }
+
+    if (programFadeRemaining == 0)
+        programSwitch.store (ProgramSwitch::idle, std::memory_order_release);
+}
+
+ObsidianSpaceAudioProcessor::EngineType ObsidianSpaceAudioProcessor::getEngineType() const noexcept
+{
+    return engineParam != nullptr ? (EngineType) juce::roundToInt (engineParam->load()) : EngineType::classic;
+}
+
+SpectralEngine::Parameters ObsidianSpaceAudioProcessor::getSpectralParameters() const noexcept
+{
+    SpectralEngine::Parameters params;
+    params.decaySeconds = cachedDecay;
+    params.dampingHz = ReverbSettings::dampingToCutoffHz (cachedDamping);
+    params.roomSize = reverbParams.roomSize;
+    params.wetLevel = reverbParams.wetLevel;
+    params.width = reverbParams.width;
+    params.freeze = cachedFreeze;
+    return params;
+}
+
+VelvetEngine::Parameters ObsidianSpaceAudioProcessor::getVelvetParameters() const noexcept
+{
+    VelvetEngine::Parameters params;
+    params.dampingHz = ReverbSettings::dampingToCutoffHz (cachedDamping);
+    params.wetLevel = reverbParams.wetLevel;
+    params.width = reverbParams.width;
+    return params;
+}
+
+ObsidianSpaceAudioProcessor::BusMode ObsidianSpaceAudioProcessor::getBusMode() const noexcept
+{
+    return busModeParam != nullptr ? (BusMode) juce::roundToInt (busModeParam->load()) : BusMode::off;
+}
+
+void ObsidianSpaceAudioProcessor::parameterChanged (const juce::String& parameterID, float newValue)
+{
+    juce::ignoreUnused (parameterID, newValue);
+    settingsChanged.store (true);
+}
+
+void ObsidianSpaceAudioProcessor::applySettingChanges()
+{
+    // Pipelining switches here rather than waiting for a prepareToPlay that
+    // many hosts never send. Processing pauses while the worker starts or
+    // stops, and the new latency is reported, so the host sees it change
+    // along with the audio.
+    if (isPrepared.load() && isPipelineRequested() != isPipelined)
+    {
+        suspendProcessing (true);
+        pipeline.stop();
+        updatePipeline (currentSampleRate, preparedBlockSize, preparedNumChannels);
+        suspendProcessing (false);
+    }
+
+    updateBusMembership();
+    qualityController.setBudget (qualityBudgetParam->load() * 0.01f);
+
+    if (isAllocated())
+        velvetEngine.requestTables (decayParam->load(), ReverbSettings::normaliseRoomSize (roomSizeParam->load()));
+}
+
+void ObsidianSpaceAudioProcessor::updateBusMembership()
+{
+    const auto mode = getBusMode();
+    auto* bus = mode != BusMode::off ? &busRegistry->getBus (juce::roundToInt (busIdParam->load())) : nullptr;
+
+    if (bus == joinedBus && mode == joinedMode)
+        return;
+
+    leaveBus();
+
+    if (bus == nullptr)
+        return;
+
+    if (mode == BusMode::send && bus->addSend (busSend))
+    {
+        joinedBus = bus;
+        joinedMode = mode;
+    }
+    else if (mode == BusMode::receive && bus->claimReturn (this))
+    {
+        joinedBus = bus;
+        joinedMode = mode;
+        receivingBus.store (bus, std::memory_order_release);
+    }
+}
+
+void ObsidianSpaceAudioProcessor::leaveBus()
+{
+    if (joinedBus == nullptr)
+        return;
+
+    if (joinedMode == BusMode::send)
+    {
+        joinedBus->removeSend (busSend);
+    }
+    else
+    {
+        receivingBus.store (nullptr, std::memory_order_release);
+        joinedBus->releaseReturn (this);
+    }
+
+    joinedBus = nullptr;
+    joinedMode = BusMode::off;
 }
 
 //==============================================================================
 bool ObsidianSpaceAudioProcessor::hasEditor() const
 {
-    return true;
+    return ! OBSIDIAN_HEADLESS;
 }
 
 juce::AudioProcessorEditor* ObsidianSpaceAudioProcessor::createEditor()
 {
+   #if OBSIDIAN_HEADLESS
+    return nullptr;
+   #else
     return new ObsidianSpaceAudioProcessorEditor (*this);
+   #endif
 }
 
 //==============================================================================
 void ObsidianSpaceAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml (state.createXml());
-    copyXmlToBinary (*xml, destData);
+    auto state = PluginState::capture (apvts);
+    state.references.set ("program", FactoryPresets::get (currentProgram.load()).name);
+    state.writeTo (destData);
 }
 
 void ObsidianSpaceAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    if (PluginState::isBinaryState (data, sizeInBytes))
+    {
+        if (auto state = PluginState::readFrom (data, sizeInBytes))
+        {
+            state->applyTo (apvts);
+            currentProgram = juce::jmax (0, FactoryPresets::indexOf (state->references["program"]));
+        }
+
+        return;
+    }
+
+    // Sessions saved before the binary format store the ValueTree as XML,
+    // with no program, so they come back on the first one.
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
 
     if (xmlState.get() != nullptr)
+    {
         if (xmlState->hasTagName (apvts.state.getType()))
+        {
             apvts.replaceState (juce::ValueTree::fromXml (*xmlState));
+            currentProgram = 0;
+        }
+    }
 }
 
 //==============================================================================
@@ -224,10 +907,11 @@ void ObsidianSpaceAudioProcessor::updateParameters()
     float highCut = highCutParam->load();
     
     bool needsUpdate = false;
+    bool needsSpectralUpdate = false;
     
     if (std::abs (roomSize - cachedRoomSize) > tolerance)
     {
-        reverbParams.roomSize = juce::jlimit (0.0f, 1.0f, roomSize / 100.0f);
+        reverbParams.roomSize = ReverbSettings::normaliseRoomSize (roomSize);
         cachedRoomSize = roomSize;
         needsUpdate = true;
     }
@@ -235,6 +919,7 @@ void ObsidianSpaceAudioProcessor::updateParameters()
     if (std::abs (decay - cachedDecay) > tolerance)
     {
         cachedDecay = decay;
+        needsSpectralUpdate = true;
     }
 
     if (std::abs (preDelay - cachedPreDelay) > tolerance)
@@ -244,29 +929,33 @@ void ObsidianSpaceAudioProcessor::updateParameters()
 
     if (std::abs (damping - cachedDamping) > tolerance)
     {
-        auto dampingNorm = (std::log (damping) - std::log (1000.0f))
-                           / (std::log (20000.0f) - std::log (1000.0f));
-        reverbParams.damping = juce::jlimit (0.0f, 1.0f, dampingNorm);
+        reverbParams.damping = ReverbSettings::normaliseDamping (damping);
         cachedDamping = damping;
         needsUpdate = true;
     }
     
     if (std::abs (mix - cachedMix) > tolerance)
     {
-        auto wet = juce::jlimit (0.0f, 1.0f, mix / 100.0f);
-        reverbParams.wetLevel = wet;
-        reverbParams.dryLevel = 1.0f - wet;
+        reverbParams.wetLevel = ReverbSettings::normaliseMix (mix);
         cachedMix = mix;
         needsUpdate = true;
     }
     
     if (std::abs (width - cachedWidth) > tolerance)
     {
-        reverbParams.width = juce::jlimit (0.0f, 1.0f, width / 200.0f);
+        reverbParams.width = ReverbSettings::normaliseWidth (width);
         cachedWidth = width;
         needsUpdate = true;
     }
     
+    const bool freeze = freezeParam != nullptr && freezeParam->load() > 0.5f;
+    if (freeze != cachedFreeze)
+    {
+        reverbParams.freezeMode = freeze ? 1.0f : 0.0f;
+        cachedFreeze = freeze;
+        needsUpdate = true;
+    }
+
     if (std::abs (lowCut - cachedLowCut) > tolerance)
     {
         cachedLowCut = lowCut;
@@ -279,8 +968,14 @@ void ObsidianSpaceAudioProcessor::updateParameters()
     
     if (needsUpdate)
     {
-        reverb.setParameters (reverbParams);
+        getActiveEngine().setParameters (reverbParams);
     }
+
+    if (needsUpdate || needsSpectralUpdate)
+        spectralEngine.setParameters (getSpectralParameters());
+
+    if (needsUpdate)
+        velvetEngine.setParameters (getVelvetParameters());
 }
 
 //==============================================================================
@@ -309,7 +1004,8 @@ juce::AudioProcessorValueTreeState::ParameterLayout ObsidianSpaceAudioProcessor:
         20.0f
     ));
 
-    // Damping: 1000 to 20000 Hz, default 8000
+    // Damping: 1000 to 20000 Hz, default 8000. Higher values darken the
+    // tail in every engine; see ReverbSettings::dampingToCutoffHz
     params.push_back (std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID ("DAMPING", 1), "Damping",
         juce::NormalisableRange<float> (1000.0f, 20000.0f, 1.0f),
@@ -349,6 +1045,47 @@ juce::AudioProcessorValueTreeState::ParameterLayout ObsidianSpaceAudioProcessor:
         juce::ParameterID ("POWER", 1), "Power", true
     ));
 
+    // Freeze: hold the current tail indefinitely, default off
+    params.push_back (std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID ("FREEZE", 1), "Freeze", false
+    ));
+
+    // Bus mode: run as a normal insert, feed a shared bus, or be its return
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("BUSMODE", 1), "Bus Mode",
+        juce::StringArray { "Off", "Send", "Return" }, 0
+    ));
+
+    // Bus ID: which of the shared buses to send to or return from
+    params.push_back (std::make_unique<juce::AudioParameterInt>(
+        juce::ParameterID ("BUSID", 1), "Bus ID", 1, ReverbBusRegistry::numBuses, 1
+    ));
+
+    // Engine: the Freeverb-style network, the spectral engine for very long
+    // tails, or the sparse velvet-noise tail
+    params.push_back (std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID ("ENGINE", 1), "Engine",
+        juce::StringArray { "Classic", "Spectral", "Velvet" }, 0
+    ));
+
+    // Pipelined processing: run the wet path on its own thread for more
+    // headroom, at the cost of one block of latency. Not automatable, since
+    // switching briefly pauses processing and changes the latency.
+    params.push_back (std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID ("PIPELINE", 1), "Pipelined Processing", false,
+        juce::AudioParameterBoolAttributes().withAutomatable (false)
+    ));
+
+    // Quality budget: the share of each block's deadline the reverb may use
+    // before it drops to reduced quality; 10 to 100 %, default 75. Saved with
+    // the session but not automatable, as it tunes the machine, not the sound.
+    params.push_back (std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID ("QUALITYBUDGET", 1), "Quality Budget",
+        juce::NormalisableRange<float> (10.0f, 100.0f, 1.0f),
+        75.0f,
+        juce::AudioParameterFloatAttributes().withAutomatable (false)
+    ));
+
     return { params.begin(), params.end() };
 }
 
@@ -9,6 +9,27 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "DspLoadMeter.h"
+#include "QualityController.h"
+#include "StageProfiler.h"
+#include "WetSignalFifo.h"
+#include "ReverbSettings.h"
+#include "PluginState.h"
+#include "FactoryPresets.h"
+#include "ReverbEngine.h"
+#include "SpectralEngine.h"
+#include "VelvetEngine.h"
+#include "FreezeLooper.h"
+#include "ReverbBus.h"
+#include "WetPipeline.h"
+#include "DspAllocator.h"
+#include "OutputStage.h"
+
+// Built with OBSIDIAN_HEADLESS=1 by the headless library project, which
+// leaves out the editor and every GUI module for render servers.
+#ifndef OBSIDIAN_HEADLESS
+ #define OBSIDIAN_HEADLESS 0
+#endif
 
 //==============================================================================
 /**
@@ -17,6 +38,10 @@ class ObsidianSpaceAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                             , private juce::Timer
+                             , private juce::AudioProcessorValueTreeState::Listener
+                             , private WetPipeline::Stage
+                             , private DspAllocator::Client
 {
 public:
     //==============================================================================
@@ -71,16 +96,161 @@ public:
     std::atomic<float>* lowCutParam = nullptr;
     std::atomic<float>* highCutParam = nullptr;
     std::atomic<float>* powerParam = nullptr;
+    std::atomic<float>* freezeParam = nullptr;
+    std::atomic<float>* busModeParam = nullptr;
+    std::atomic<float>* busIdParam = nullptr;
+    std::atomic<float>* engineParam = nullptr;
+    std::atomic<float>* pipelineParam = nullptr;
+    std::atomic<float>* qualityBudgetParam = nullptr;
+
+    const DspLoadMeter& getLoadMeter() const noexcept { return loadMeter; }
+    QualityController& getQualityController() noexcept { return qualityController; }
+    const QualityController& getQualityController() const noexcept { return qualityController; }
+    WetSignalFifo& getWetSignalFifo() noexcept { return wetSignalFifo; }
+
+    // False until the engines' memory exists, which for realtime playback
+    // is after the first non-silent block.
+    bool isDspAllocated() const noexcept { return isAllocated(); }
 
 private:
     //==============================================================================
-    // DSP processing
-    juce::dsp::Reverb reverb;
-    juce::dsp::Reverb::Parameters reverbParams;
-    
+    // DSP processing. Two engines so a program change can build the new
+    // configuration on the message thread and crossfade tails on the audio
+    // thread, without resetting or reconfiguring the engine that is playing.
+    std::array<ReverbEngine, 2> engines;
+    std::atomic<int> activeEngine { 0 };
+    ReverbEngine::Parameters reverbParams;
+
+    ReverbEngine& getActiveEngine() noexcept { return engines[(size_t) activeEngine.load (std::memory_order_relaxed)]; }
+    ReverbEngine& getStandbyEngine() noexcept { return engines[(size_t) (1 - activeEngine.load (std::memory_order_relaxed))]; }
+
+    // Program switches: idle -> preparing (message thread configures the
+    // standby engine) -> ready -> fading (audio thread owns both engines).
+    enum class ProgramSwitch { idle, preparing, ready, fading };
+    std::atomic<ProgramSwitch> programSwitch { ProgramSwitch::idle };
+    std::atomic<int> currentProgram { 0 };
+    std::atomic<bool> isPrepared { false };
+    int queuedProgram = -1;
+    static constexpr double programFadeSeconds = 0.3;
+    int programFadeLength = 0;
+    int programFadeRemaining = 0;
+    juce::AudioBuffer<float> fadeBuffer;
+
+    // Engine choice. Switching lets the engine being left ring out under the
+    // new one over the program fade time, fed silence, then clears it. Each
+    // engine keeps its own fade level, so switching back before a fade ends
+    // ramps the returning engine up from where it was, and any number of
+    // engines can be ringing out at once.
+    enum class EngineType { classic, spectral, velvet };
+    static constexpr int numEngineTypes = 3;
+    SpectralEngine spectralEngine;
+    VelvetEngine velvetEngine;
+    EngineType currentEngineType = EngineType::classic;
+
+    // In samples of the program fade: programFadeLength is full level, and
+    // 0 is silent with the engine cleared.
+    std::array<int, (size_t) numEngineTypes> engineLevels {};
+
+    EngineType getEngineType() const noexcept;
+    SpectralEngine::Parameters getSpectralParameters() const noexcept;
+    VelvetEngine::Parameters getVelvetParameters() const noexcept;
+    void processEngine (EngineType type, juce::dsp::ProcessContextReplacing<float>& context);
+    void processActiveEngine (juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples);
+    void fadeInActiveEngine (juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples);
+    void ringOutEngine (EngineType type, juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples);
+    void resetEngine (EngineType type);
+    void endProgramCrossfade();
+
+    FreezeLooper freezeLooper;
+
+    // Send/return bus. Sends pass their input through and feed the bus at
+    // the MIX level; the one return per bus adds the bus into its engine.
+    // Membership changes on the message thread.
+    enum class BusMode { off, send, receive };
+    juce::SharedResourcePointer<ReverbBusRegistry> busRegistry;
+    ReverbBus::Send busSend;
+    ReverbBus* joinedBus = nullptr;
+    BusMode joinedMode = BusMode::off;
+    std::atomic<ReverbBus*> receivingBus { nullptr };
+    float lastSendGain = 0.0f;
+
+    BusMode getBusMode() const noexcept;
+    // Parameter listeners can run on the audio thread, so they only flag
+    // the change; the timer applies it on the message thread. It also
+    // retries queued program changes.
+    static constexpr int timerIntervalMs = 20;
+    std::atomic<bool> settingsChanged { false };
+
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+    void applySettingChanges();
+    void updateBusMembership();
+    void leaveBus();
+
+    bool beginProgramSwitch (int index);
+    void timerCallback() override;
+    void processProgramCrossfade (juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples);
+    void resetEngines();
+
+    // The reverb runs wet-only so the tail can be analysed before the dry
+    // signal is mixed back in, in the same pass as the tone filters. The
+    // engine scales its dry level by 2, which is kept here so existing
+    // sessions sound the same.
+    static constexpr float dryScaleFactor = 2.0f;
+    juce::AudioBuffer<float> dryBuffer;
+    juce::AudioBuffer<float> filteredWetBuffer; // for the visualizer only
+    OutputStage outputStage;
+
+    // Optional pipelining: the wet path runs on its own thread a block
+    // behind, and the dry path is delayed to match. Switched in
+    // prepareToPlay, or with processing suspended when PIPELINE changes;
+    // with it off there is no thread at all.
+    WetPipeline pipeline { *this };
+    bool isPipelined = false;
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> dryDelay;
+
+    bool isPipelineRequested() const noexcept;
+    void updatePipeline (double sampleRate, int samplesPerBlock, int numChannels);
+    void delayDrySignal (juce::AudioBuffer<float>& buffer, int numChannels, int numSamples);
+    void processSubBlock (juce::AudioBuffer<float>& buffer, int numChannels, bool isOffline);
+    void processWet (juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples) override;
+    void resetWet() override;
+
+    // Lazy allocation: prepareToPlay sets everything up except the engines,
+    // whose delay memory is allocated on the shared allocator thread once
+    // signal first arrives. Until then the wet path is silent, and it fades
+    // in once the engines are ready. Offline rendering allocates up front,
+    // so a bounce never loses the start of its tail.
+    juce::SharedResourcePointer<DspAllocator> dspAllocator;
+    juce::dsp::ProcessSpec preparedSpec {};
+    juce::SmoothedValue<float> wetFadeIn;
+    static constexpr double wetFadeInSeconds = 0.05;
+
+    void prepareEngines (const juce::dsp::ProcessSpec& spec);
+    void requestAllocationIfAudible (const juce::dsp::AudioBlock<float>& block, bool allocateOnThisThread);
+    void allocate() override;
+    void allocationFinished() override;
+
+    // Offline rendering has no deadline: quality stays at full, and the
+    // audio thread waits for the pipeline worker and the allocator rather
+    // than playing silence. Read once per block, so a host can switch
+    // between bounces and playback at any time without a re-prepare.
+    std::atomic<bool> isRenderingOffline { false };
+
     void updateParameters();
     
     double currentSampleRate = 44100.0;
+    int preparedBlockSize = 0;
+    int preparedNumChannels = 0;
+    DspLoadMeter loadMeter;
+    QualityController qualityController;
+    WetSignalFifo wetSignalFifo;
+
+   #if OBSIDIAN_ENABLE_PROFILING
+    StageProfiler profiler;
+
+    // The pipeline worker's stages; a profiler takes records from one thread.
+    StageProfiler workerProfiler;
+   #endif
 
     // Cached parameter values
     float cachedRoomSize = 50.0f;
@@ -92,6 +262,7 @@ private:
     float cachedLowCut = 20.0f;
     float cachedHighCut = 12000.0f;
     bool cachedPower = true;
+    bool cachedFreeze = false;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ObsidianSpaceAudioProcessor)
 };
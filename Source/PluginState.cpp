@@ -0,0 +1,191 @@
+#include "PluginState.h"
+
+namespace
+{
+    constexpr juce::uint32 makeTag (char a, char b, char c, char d) noexcept
+    {
+        return (juce::uint32) (juce::uint8) a
+             | ((juce::uint32) (juce::uint8) b << 8)
+             | ((juce::uint32) (juce::uint8) c << 16)
+             | ((juce::uint32) (juce::uint8) d << 24);
+    }
+
+    constexpr auto magicTag = makeTag ('O', 'B', 'S', 'S');
+    constexpr auto parametersTag = makeTag ('P', 'A', 'R', 'M');
+    constexpr auto referencesTag = makeTag ('R', 'E', 'F', 'S');
+    constexpr int headerSize = 8;
+    constexpr int chunkHeaderSize = 8;
+
+    void writeChunk (juce::MemoryOutputStream& out, juce::uint32 tag, const juce::MemoryOutputStream& payload)
+    {
+        out.writeInt ((int) tag);
+        out.writeInt ((int) payload.getDataSize());
+        out.write (payload.getData(), payload.getDataSize());
+    }
+
+    // Readers over a single chunk, which fail rather than run past its end.
+    bool readString (juce::MemoryInputStream& in, juce::String& result)
+    {
+        if (in.isExhausted())
+            return false;
+
+        result = in.readString();
+
+        // A string cut off by the end of the chunk has no terminator.
+        return static_cast<const char*> (in.getData())[in.getPosition() - 1] == 0;
+    }
+
+    bool readFloat (juce::MemoryInputStream& in, float& result)
+    {
+        if (in.getNumBytesRemaining() < (juce::int64) sizeof (float))
+            return false;
+
+        result = in.readFloat();
+        return true;
+    }
+
+    // Reads an entry count, and checks the chunk has room for that many
+    // entries of at least minimumEntryBytes each.
+    bool readCount (juce::MemoryInputStream& in, int minimumEntryBytes, int& result)
+    {
+        result = in.readCompressedInt();
+        return result >= 0 && result <= in.getNumBytesRemaining() / minimumEntryBytes;
+    }
+}
+
+PluginState PluginState::capture (const juce::AudioProcessorValueTreeState& apvts)
+{
+    PluginState state;
+
+    for (auto* parameter : apvts.processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter))
+            state.parameters.push_back ({ ranged->getParameterID(), ranged->convertFrom0to1 (ranged->getValue()) });
+
+    return state;
+}
+
+void PluginState::applyTo (juce::AudioProcessorValueTreeState& apvts) const
+{
+    for (auto* parameter : apvts.processor.getParameters())
+    {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (parameter);
+        if (ranged == nullptr)
+            continue;
+
+        auto normalised = ranged->getDefaultValue();
+
+        for (auto& saved : parameters)
+        {
+            if (saved.id == ranged->getParameterID())
+            {
+                normalised = ranged->convertTo0to1 (saved.value);
+                break;
+            }
+        }
+
+        ranged->setValueNotifyingHost (normalised);
+    }
+}
+
+void PluginState::writeTo (juce::MemoryBlock& destData) const
+{
+    juce::MemoryOutputStream out (destData, false);
+    out.writeInt ((int) magicTag);
+    out.writeInt ((int) currentVersion);
+
+    {
+        juce::MemoryOutputStream payload;
+        payload.writeCompressedInt ((int) parameters.size());
+
+        for (auto& parameter : parameters)
+        {
+            payload.writeString (parameter.id);
+            payload.writeFloat (parameter.value);
+        }
+
+        writeChunk (out, parametersTag, payload);
+    }
+
+    if (references.size() > 0)
+    {
+        juce::MemoryOutputStream payload;
+        payload.writeCompressedInt (references.size());
+
+        for (int i = 0; i < references.size(); ++i)
+        {
+            payload.writeString (references.getAllKeys()[i]);
+            payload.writeString (references.getAllValues()[i]);
+        }
+
+        writeChunk (out, referencesTag, payload);
+    }
+}
+
+bool PluginState::isBinaryState (const void* data, int sizeInBytes) noexcept
+{
+    return data != nullptr && sizeInBytes >= headerSize
+        && juce::ByteOrder::littleEndianInt (data) == magicTag;
+}
+
+std::optional<PluginState> PluginState::readFrom (const void* data, int sizeInBytes)
+{
+    if (! isBinaryState (data, sizeInBytes))
+        return {};
+
+    juce::MemoryInputStream in (data, (size_t) sizeInBytes, false);
+    in.skipNextBytes (4);
+
+    if ((juce::uint32) in.readInt() != currentVersion)
+        return {};
+
+    PluginState state;
+
+    while (in.getNumBytesRemaining() >= chunkHeaderSize)
+    {
+        const auto tag = (juce::uint32) in.readInt();
+        const auto size = (juce::int64) (juce::uint32) in.readInt();
+
+        if (size > in.getNumBytesRemaining())
+            return {};
+
+        juce::MemoryInputStream chunk (static_cast<const char*> (data) + in.getPosition(), (size_t) size, false);
+        in.skipNextBytes (size);
+        int count = 0;
+
+        if (tag == parametersTag)
+        {
+            // An entry is at least an empty ID and a float.
+            if (! readCount (chunk, 1 + (int) sizeof (float), count))
+                return {};
+
+            state.parameters.reserve ((size_t) count);
+
+            for (int i = 0; i < count; ++i)
+            {
+                ParameterValue parameter;
+
+                if (! readString (chunk, parameter.id) || ! readFloat (chunk, parameter.value))
+                    return {};
+
+                state.parameters.push_back (std::move (parameter));
+            }
+        }
+        else if (tag == referencesTag)
+        {
+            if (! readCount (chunk, 2, count))
+                return {};
+
+            for (int i = 0; i < count; ++i)
+            {
+                juce::String key, value;
+
+                if (! readString (chunk, key) || ! readString (chunk, value))
+                    return {};
+
+                state.references.set (key, value);
+            }
+        }
+    }
+
+    return state;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// The saved state of one plugin instance: every parameter value plus named
+// references to external resources such as presets or impulse responses.
+//
+// Stored as a compact binary blob that is decoded straight into parameter
+// values, without building a ValueTree or XML document:
+//
+//   uint32 magic ("OBSS"), uint32 version, then chunks of
+//   uint32 tag, uint32 payload size, payload
+//
+// All integers are little-endian. Readers skip chunks they don't recognise,
+// so new chunks can be added without bumping the version; the version only
+// changes if the layout above does.
+struct PluginState
+{
+    struct ParameterValue
+    {
+        juce::String id;
+        float value = 0.0f;
+    };
+
+    std::vector<ParameterValue> parameters;
+    juce::StringPairArray references;
+
+    static PluginState capture (const juce::AudioProcessorValueTreeState& apvts);
+
+    // Parameters missing from the state go back to their defaults.
+    void applyTo (juce::AudioProcessorValueTreeState& apvts) const;
+
+    void writeTo (juce::MemoryBlock& destData) const;
+
+    static bool isBinaryState (const void* data, int sizeInBytes) noexcept;
+    static std::optional<PluginState> readFrom (const void* data, int sizeInBytes);
+
+    static constexpr juce::uint32 currentVersion = 1;
+};
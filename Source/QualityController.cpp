@@ -0,0 +1,66 @@
+#include "QualityController.h"
+
+void QualityController::prepare (double sampleRate)
+{
+    jassert (sampleRate > 0.0);
+    secondsPerSample = 1.0 / sampleRate;
+    reset();
+}
+
+void QualityController::reset() noexcept
+{
+    smoothedLoad = 0.0f;
+    secondsOverBudget = 0.0;
+    secondsWithHeadroom = 0.0;
+    recoverySeconds = minimumRecoverySeconds;
+    secondsSinceRecovery = maximumRecoverySeconds;
+    level.store (Level::full, std::memory_order_relaxed);
+}
+
+void QualityController::setBudget (float fractionOfDeadline) noexcept
+{
+    budget.store (juce::jlimit (0.1f, 1.0f, fractionOfDeadline), std::memory_order_relaxed);
+}
+
+QualityController::Level QualityController::update (float blockLoad, int numSamples) noexcept
+{
+    const auto current = level.load (std::memory_order_relaxed);
+
+    if (numSamples <= 0)
+        return current;
+
+    // Smoothed in real time rather than in blocks, like the load meter.
+    const auto blockSeconds = (double) numSamples * secondsPerSample;
+    smoothedLoad += (blockLoad - smoothedLoad) * (float) (blockSeconds / (blockSeconds + smoothingSeconds));
+    secondsSinceRecovery += blockSeconds;
+
+    const auto limit = budget.load (std::memory_order_relaxed);
+
+    if (current == Level::full)
+    {
+        secondsOverBudget = smoothedLoad > limit ? secondsOverBudget + blockSeconds : 0.0;
+
+        if (secondsOverBudget < overloadSeconds)
+            return current;
+
+        // Overloaded again right after recovering: wait longer next time.
+        recoverySeconds = secondsSinceRecovery < 2.0 * recoverySeconds
+                              ? juce::jmin (maximumRecoverySeconds, recoverySeconds * 2.0)
+                              : minimumRecoverySeconds;
+
+        secondsOverBudget = 0.0;
+        secondsWithHeadroom = 0.0;
+        level.store (Level::reduced, std::memory_order_relaxed);
+        return Level::reduced;
+    }
+
+    secondsWithHeadroom = smoothedLoad < limit * recoveryFraction ? secondsWithHeadroom + blockSeconds : 0.0;
+
+    if (secondsWithHeadroom < recoverySeconds)
+        return current;
+
+    secondsWithHeadroom = 0.0;
+    secondsSinceRecovery = 0.0;
+    level.store (Level::full, std::memory_order_relaxed);
+    return Level::full;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Drops the reverb to a cheaper quality level when processBlock keeps using
+// more than its budget of the real-time deadline, and brings it back once
+// there is headroom again. A short spike never triggers it; only load held
+// over budget does. Each drop soon after a recovery waits longer before
+// trying again, so an instance hovering at the limit doesn't flap.
+// Updated from the audio thread; the level can be read from any thread.
+class QualityController
+{
+public:
+    enum class Level { full, reduced };
+
+    void prepare (double sampleRate);
+    void reset() noexcept;
+
+    // The fraction of each block's deadline processBlock may take before
+    // quality drops; 0.75 by default.
+    void setBudget (float fractionOfDeadline) noexcept;
+    float getBudget() const noexcept { return budget.load (std::memory_order_relaxed); }
+
+    // Feeds in one block's load (its processing time over its duration) and
+    // returns the level to process the next block at.
+    Level update (float blockLoad, int numSamples) noexcept;
+
+    Level getLevel() const noexcept { return level.load (std::memory_order_relaxed); }
+
+private:
+    static constexpr double smoothingSeconds = 0.05;
+    static constexpr double overloadSeconds = 0.1;
+    static constexpr double minimumRecoverySeconds = 2.0;
+    static constexpr double maximumRecoverySeconds = 30.0;
+
+    // Reduced quality has to run this far below budget before full quality
+    // is assumed to fit again.
+    static constexpr float recoveryFraction = 0.6f;
+
+    double secondsPerSample = 1.0 / 44100.0;
+    float smoothedLoad = 0.0f;
+    double secondsOverBudget = 0.0;
+    double secondsWithHeadroom = 0.0;
+    double recoverySeconds = minimumRecoverySeconds;
+    double secondsSinceRecovery = 0.0;
+
+    std::atomic<float> budget { 0.75f };
+    std::atomic<Level> level { Level::full };
+
+    static_assert (std::atomic<Level>::is_always_lock_free, "Quality level must be lock-free");
+};
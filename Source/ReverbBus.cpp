@@ -0,0 +1,134 @@
+#include "ReverbBus.h"
+
+void ReverbBus::Send::prepare (int maximumBlockSize)
+{
+    const auto capacity = juce::jmax (8192, maximumBlockSize * 8);
+
+    if (capacity != fifo.getTotalSize())
+    {
+        fifo.setTotalSize (capacity);
+        buffer.setSize (numChannels, capacity);
+    }
+
+    fifo.reset();
+    buffer.clear();
+}
+
+void ReverbBus::Send::push (const juce::AudioBuffer<float>& source, int sourceChannels, int numSamples,
+                            float startGain, float endGain) noexcept
+{
+    if (sourceChannels <= 0 || fifo.getFreeSpace() < numSamples)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    const auto splitGain = startGain + (endGain - startGain) * (float) size1 / (float) numSamples;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        // Mono sends feed both sides of the bus.
+        const auto sourceChannel = juce::jmin (channel, sourceChannels - 1);
+
+        if (size1 > 0)
+            buffer.copyFromWithRamp (channel, start1, source.getReadPointer (sourceChannel), size1, startGain, splitGain);
+
+        if (size2 > 0)
+            buffer.copyFromWithRamp (channel, start2, source.getReadPointer (sourceChannel, size1), size2, splitGain, endGain);
+    }
+
+    fifo.finishedWrite (size1 + size2);
+}
+
+bool ReverbBus::addSend (Send& send) noexcept
+{
+    send.isPrimed = false;
+
+    for (auto& slot : sends)
+    {
+        Send* expected = nullptr;
+        if (slot.compare_exchange_strong (expected, &send))
+            return true;
+    }
+
+    return false;
+}
+
+void ReverbBus::removeSend (Send& send) noexcept
+{
+    for (auto& slot : sends)
+    {
+        Send* expected = &send;
+        if (slot.compare_exchange_strong (expected, nullptr))
+            break;
+    }
+
+    // A return that loaded the pointer before it was cleared is still
+    // counted here; wait for it to finish with the send.
+    while (activeReaders.load() > 0)
+        juce::Thread::yield();
+}
+
+bool ReverbBus::claimReturn (const void* owner) noexcept
+{
+    const void* expected = nullptr;
+    return returnOwner.compare_exchange_strong (expected, owner) || expected == owner;
+}
+
+void ReverbBus::releaseReturn (const void* owner) noexcept
+{
+    const void* expected = owner;
+    returnOwner.compare_exchange_strong (expected, nullptr);
+}
+
+void ReverbBus::addSendsTo (juce::AudioBuffer<float>& destination, int destinationChannels, int numSamples) noexcept
+{
+    activeReaders.fetch_add (1);
+
+    for (auto& slot : sends)
+    {
+        auto* send = slot.load();
+        if (send == nullptr)
+            continue;
+
+        auto& fifo = send->fifo;
+        auto ready = fifo.getNumReady();
+
+        // Start each send with one block in hand, dropping anything stale,
+        // so host thread ordering can't starve the return from block to block.
+        // Drift beyond a few blocks is dropped the same way.
+        if (! send->isPrimed || ready > numSamples * 4)
+        {
+            if (ready < numSamples * 2)
+                continue;
+
+            fifo.finishedRead (ready - numSamples * 2);
+            ready = numSamples * 2;
+            send->isPrimed = true;
+        }
+
+        if (ready < numSamples)
+        {
+            send->isPrimed = false;
+            continue;
+        }
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (numSamples, start1, size1, start2, size2);
+
+        for (int channel = 0; channel < destinationChannels; ++channel)
+        {
+            const auto busChannel = juce::jmin (channel, numChannels - 1);
+
+            if (size1 > 0)
+                destination.addFrom (channel, 0, send->buffer, busChannel, start1, size1);
+
+            if (size2 > 0)
+                destination.addFrom (channel, size1, send->buffer, busChannel, start2, size2);
+        }
+
+        fifo.finishedRead (size1 + size2);
+    }
+
+    activeReaders.fetch_sub (1);
+}
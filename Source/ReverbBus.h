@@ -0,0 +1,67 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// A shared send/return bus inside one process. Any number of send
+// instances feed one return instance, which runs a single engine for all of
+// them. Each send owns a FIFO that only it writes and only the return reads,
+// so both sides are wait-free whatever threads the host runs them on.
+class ReverbBus
+{
+public:
+    static constexpr int maximumSends = 64;
+    static constexpr int numChannels = 2;
+
+    class Send
+    {
+    public:
+        // Not while the owner's audio thread is running.
+        void prepare (int maximumBlockSize);
+
+        // The owner's audio thread. Drops the block if the return has fallen
+        // behind or isn't running.
+        void push (const juce::AudioBuffer<float>& source, int sourceChannels, int numSamples,
+                   float startGain, float endGain) noexcept;
+
+    private:
+        friend class ReverbBus;
+
+        juce::AbstractFifo fifo { 1 };
+        juce::AudioBuffer<float> buffer;
+
+        // Touched only by the return's audio thread.
+        bool isPrimed = false;
+    };
+
+    // Message thread. Removing waits for a return that is reading the send
+    // to finish its block, after which the send may be reused or destroyed.
+    bool addSend (Send& send) noexcept;
+    void removeSend (Send& send) noexcept;
+
+    // Message thread. A bus has at most one return; others stay inserts.
+    bool claimReturn (const void* owner) noexcept;
+    void releaseReturn (const void* owner) noexcept;
+
+    // The return's audio thread. Adds one block from every send into the
+    // destination. Each send runs a block behind on its first read, so the
+    // return gets whole blocks whether it runs before or after the sends.
+    void addSendsTo (juce::AudioBuffer<float>& destination, int destinationChannels, int numSamples) noexcept;
+
+private:
+    std::array<std::atomic<Send*>, (size_t) maximumSends> sends {};
+    std::atomic<const void*> returnOwner { nullptr };
+    std::atomic<int> activeReaders { 0 };
+};
+
+// The process-wide set of buses, shared through a SharedResourcePointer.
+class ReverbBusRegistry
+{
+public:
+    static constexpr int numBuses = 16;
+
+    // Bus IDs run from 1 to numBuses.
+    ReverbBus& getBus (int busId) noexcept { return buses[(size_t) juce::jlimit (1, numBuses, busId) - 1]; }
+
+private:
+    std::array<ReverbBus, (size_t) numBuses> buses;
+};
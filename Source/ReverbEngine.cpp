@@ -0,0 +1,331 @@
+#include "ReverbEngine.h"
+
+namespace
+{
+    // Freeverb's tunings, in samples at 44.1 kHz.
+    constexpr std::array<int, 8> combTunings { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+    constexpr std::array<int, 4> allPassTunings { 556, 441, 341, 225 };
+    constexpr int stereoSpread = 23;
+    constexpr double networkFadeSeconds = 0.02;
+
+    int scaleTuning (double sampleRate, int tuning) noexcept
+    {
+        return juce::jmax (1, ((int) sampleRate * tuning) / 44100);
+    }
+}
+
+ReverbEngine::ReverbEngine()
+{
+    setParameters ({});
+    networkGain.setCurrentAndTargetValue (1.0f);
+}
+
+void ReverbEngine::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    jassert (spec.sampleRate > 0.0);
+    jassert (spec.numChannels > 0 && spec.numChannels <= (juce::uint32) maximumChannels);
+
+    if (memory == nullptr)
+        kernels = &DspKernels::getBestKernels();
+
+    preparedChannels = juce::jlimit (1, maximumChannels, (int) spec.numChannels);
+    selectNetwork();
+
+    if (spec.sampleRate == currentSampleRate)
+        return;
+
+    const auto required = getRequiredMemory (spec.sampleRate);
+
+    if (required > memoryCapacity)
+    {
+        memoryCapacity = juce::jmax (required, getRequiredMemory (maximumSampleRate));
+        memory.allocate (memoryCapacity, false);
+    }
+
+    currentSampleRate = spec.sampleRate;
+    setDelayLengths (spec.sampleRate);
+
+    const auto smoothTime = 0.01;
+    damping.reset (spec.sampleRate, smoothTime);
+    feedback.reset (spec.sampleRate, smoothTime);
+    dryGain.reset (spec.sampleRate, smoothTime);
+    wetGain1.reset (spec.sampleRate, smoothTime);
+    wetGain2.reset (spec.sampleRate, smoothTime);
+    networkGain.reset (spec.sampleRate, networkFadeSeconds);
+    upperCombsFadeLength = juce::jmax (1, juce::roundToInt (spec.sampleRate * networkFadeSeconds));
+
+    reset();
+}
+
+void ReverbEngine::setKernels (const DspKernels::Kernels& kernelsToUse) noexcept
+{
+    kernels = &kernelsToUse;
+    selectNetwork();
+}
+
+void ReverbEngine::setNetworkSize (NetworkSize newSize) noexcept
+{
+    if (newSize == networkSize)
+        return;
+
+    networkSize = newSize;
+    selectNetwork();
+
+    // Half the combs carry half the energy, so the reduced network is
+    // driven harder to keep the tail at the same level.
+    const auto isFull = newSize == NetworkSize::full;
+    networkGain.setTargetValue (isFull ? 1.0f : juce::MathConstants<float>::sqrt2);
+
+    if (isFull)
+    {
+        upperCombsFadeRemaining = 0;
+        clearUpperCombs();
+    }
+    else
+    {
+        upperCombsFadeRemaining = upperCombsFadeLength;
+    }
+}
+
+void ReverbEngine::clearUpperCombs() noexcept
+{
+    if (memoryInUse == 0)
+        return;
+
+    for (int channel = 0; channel < maximumChannels; ++channel)
+    {
+        for (int i = numCombs / 2; i < numCombs; ++i)
+        {
+            const auto lane = (size_t) (channel * DspKernels::CombBank::lanesPerChannel + i);
+            juce::FloatVectorOperations::clear (memory.get() + combs.offsets[lane], combs.sizes[lane]);
+            combs.indices[lane] = 0;
+            combs.last[lane] = 0.0f;
+        }
+    }
+}
+
+// Only runs for a few milliseconds after the network shrinks, so it stays
+// plain scalar code.
+void ReverbEngine::fadeOutUpperCombs (int numChannels, const float* input, const float* damp, const float* feedbackLevel,
+                                      float* outLeft, float* outRight, int numSamples) noexcept
+{
+    const auto startRemaining = upperCombsFadeRemaining;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* out = channel == 0 ? outLeft : outRight;
+
+        for (int j = numCombs / 2; j < numCombs; ++j)
+        {
+            const auto lane = (size_t) (channel * DspKernels::CombBank::lanesPerChannel + j);
+            auto* line = memory.get() + combs.offsets[lane];
+            auto index = combs.indices[lane];
+            auto last = combs.last[lane];
+            auto remaining = startRemaining;
+
+            for (int i = 0; i < numSamples && remaining > 0; ++i, --remaining)
+            {
+                const auto output = line[index];
+                last = (output * (1.0f - damp[i])) + (last * damp[i]);
+                JUCE_UNDENORMALISE (last);
+
+                auto temp = input[i] + (last * feedbackLevel[i]);
+                JUCE_UNDENORMALISE (temp);
+                line[index] = temp;
+
+                if (++index >= combs.sizes[lane])
+                    index = 0;
+
+                out[i] += output * (float) remaining / (float) upperCombsFadeLength;
+            }
+
+            combs.indices[lane] = index;
+            combs.last[lane] = last;
+        }
+    }
+
+    upperCombsFadeRemaining = juce::jmax (0, startRemaining - numSamples);
+}
+
+void ReverbEngine::selectNetwork() noexcept
+{
+    const auto isFull = networkSize == NetworkSize::full;
+
+    if (preparedChannels == 1)
+    {
+        processNetwork = isFull ? &ReverbEngine::processChannels<1, numCombs> : &ReverbEngine::processChannels<1, numCombs / 2>;
+        processCombs = isFull ? kernels->getCombs<1, numCombs>() : kernels->getCombs<1, numCombs / 2>();
+    }
+    else
+    {
+        processNetwork = isFull ? &ReverbEngine::processChannels<2, numCombs> : &ReverbEngine::processChannels<2, numCombs / 2>;
+        processCombs = isFull ? kernels->getCombs<2, numCombs>() : kernels->getCombs<2, numCombs / 2>();
+    }
+}
+
+void ReverbEngine::reset() noexcept
+{
+    if (memoryInUse > 0)
+        juce::FloatVectorOperations::clear (memory.get(), (int) memoryInUse);
+
+    combs.last.fill (0.0f);
+
+    damping.setCurrentAndTargetValue (damping.getTargetValue());
+    feedback.setCurrentAndTargetValue (feedback.getTargetValue());
+    dryGain.setCurrentAndTargetValue (dryGain.getTargetValue());
+    wetGain1.setCurrentAndTargetValue (wetGain1.getTargetValue());
+    wetGain2.setCurrentAndTargetValue (wetGain2.getTargetValue());
+    networkGain.setCurrentAndTargetValue (networkGain.getTargetValue());
+    upperCombsFadeRemaining = 0;
+}
+
+void ReverbEngine::setParameters (const Parameters& newParameters) noexcept
+{
+    // The same scaling as juce::Reverb, so existing sessions sound unchanged.
+    const auto wetScaleFactor = 3.0f;
+    const auto dryScaleFactor = 2.0f;
+
+    const auto wet = newParameters.wetLevel * wetScaleFactor;
+    dryGain.setTargetValue (newParameters.dryLevel * dryScaleFactor);
+    wetGain1.setTargetValue (0.5f * wet * (1.0f + newParameters.width));
+    wetGain2.setTargetValue (0.5f * wet * (1.0f - newParameters.width));
+
+    gain = newParameters.freezeMode >= 0.5f ? 0.0f : 0.015f;
+    parameters = newParameters;
+    updateDamping();
+}
+
+void ReverbEngine::updateDamping() noexcept
+{
+    const auto roomScaleFactor = 0.28f;
+    const auto roomOffset = 0.7f;
+    const auto dampScaleFactor = 0.4f;
+
+    if (parameters.freezeMode >= 0.5f)
+    {
+        damping.setTargetValue (0.0f);
+        feedback.setTargetValue (1.0f);
+    }
+    else
+    {
+        damping.setTargetValue (parameters.damping * dampScaleFactor);
+        feedback.setTargetValue (parameters.roomSize * roomScaleFactor + roomOffset);
+    }
+}
+
+size_t ReverbEngine::getRequiredMemory (double sampleRate) noexcept
+{
+    size_t total = 0;
+
+    for (int channel = 0; channel < maximumChannels; ++channel)
+    {
+        const auto spread = channel * stereoSpread;
+
+        for (auto tuning : combTunings)
+            total += (size_t) scaleTuning (sampleRate, tuning + spread);
+
+        for (auto tuning : allPassTunings)
+            total += (size_t) scaleTuning (sampleRate, tuning + spread);
+    }
+
+    return total;
+}
+
+void ReverbEngine::setDelayLengths (double sampleRate) noexcept
+{
+    auto* next = memory.get();
+    combs.memory = memory.get();
+
+    // Each channel's lines sit next to each other, in processing order.
+    for (int channel = 0; channel < maximumChannels; ++channel)
+    {
+        const auto spread = channel * stereoSpread;
+
+        for (int i = 0; i < numCombs; ++i)
+        {
+            const auto lane = (size_t) (channel * DspKernels::CombBank::lanesPerChannel + i);
+            combs.sizes[lane] = scaleTuning (sampleRate, combTunings[(size_t) i] + spread);
+            combs.offsets[lane] = (int) (next - memory.get());
+            combs.indices[lane] = 0;
+            next += combs.sizes[lane];
+        }
+
+        for (int i = 0; i < numAllPasses; ++i)
+        {
+            auto& allPass = allPasses[(size_t) channel][(size_t) i];
+            allPass.size = scaleTuning (sampleRate, allPassTunings[(size_t) i] + spread);
+            allPass.buffer = next;
+            allPass.index = 0;
+            next += allPass.size;
+        }
+    }
+
+    memoryInUse = (size_t) (next - memory.get());
+    jassert (memoryInUse <= memoryCapacity);
+}
+
+template <int numChannels, int combsPerChannel>
+void ReverbEngine::processChannels (float* left, float* right, int numSamples) noexcept
+{
+    float input[chunkSize], damp[chunkSize], feedbackLevel[chunkSize];
+    float outputLeft[chunkSize], outputRight[chunkSize], dry[chunkSize], wet1[chunkSize], wet2[chunkSize];
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const auto count = juce::jmin (chunkSize, numSamples - start);
+        auto* chunkLeft = left + start;
+        auto* chunkRight = right + start;
+
+        for (int i = 0; i < count; ++i)
+        {
+            if constexpr (numChannels == 2)
+                input[i] = (chunkLeft[i] + chunkRight[i]) * gain * networkGain.getNextValue();
+            else
+                input[i] = chunkLeft[i] * gain * networkGain.getNextValue();
+
+            damp[i] = damping.getNextValue();
+            feedbackLevel[i] = feedback.getNextValue();
+        }
+
+        processCombs (combs, input, damp, feedbackLevel, outputLeft, outputRight, count);
+
+        if constexpr (combsPerChannel < numCombs)
+            if (upperCombsFadeRemaining > 0)
+                fadeOutUpperCombs (numChannels, input, damp, feedbackLevel, outputLeft, outputRight, count);
+
+        // Each all-pass over the whole chunk in turn is the same as the
+        // chain sample by sample.
+        for (int j = 0; j < numAllPasses; ++j)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                outputLeft[i] = allPasses[0][(size_t) j].process (outputLeft[i]);
+
+                if constexpr (numChannels == 2)
+                    outputRight[i] = allPasses[1][(size_t) j].process (outputRight[i]);
+            }
+        }
+
+        if constexpr (numChannels == 2)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                dry[i] = dryGain.getNextValue();
+                wet1[i] = wetGain1.getNextValue();
+                wet2[i] = wetGain2.getNextValue();
+            }
+
+            kernels->mixStereo (chunkLeft, chunkRight, outputLeft, outputRight, wet1, wet2, dry, count);
+        }
+        else
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                chunkLeft[i] *= dryGain.getNextValue();
+                wet1[i] = wetGain1.getNextValue();
+            }
+
+            kernels->addWithGains (chunkLeft, outputLeft, wet1, count);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspKernels.h"
+
+// The Freeverb topology of juce::dsp::Reverb, producing the same output, but
+// with every delay line carved out of one block of memory sized for the
+// highest supported sample rate. Preparing again at the same rate does
+// nothing; a new rate only recomputes delay lengths and smoothing and clears
+// the lines in place, without touching the allocator. The combs and the
+// output mix run through the best DspKernels variant for the machine,
+// chosen when the engine is first prepared.
+//
+// The processing loop is compiled once per channel count and network size,
+// and prepare() picks the instance, so the per-sample loops have constant
+// trip counts and no channel branches.
+class ReverbEngine
+{
+public:
+    using Parameters = juce::Reverb::Parameters;
+
+    // The full Freeverb network, or half its combs for less CPU.
+    enum class NetworkSize { full, reduced };
+
+    ReverbEngine();
+
+    void prepare (const juce::dsp::ProcessSpec& spec);
+
+    // Overrides the kernels picked by prepare(), e.g. to compare variants.
+    void setKernels (const DspKernels::Kernels& kernelsToUse) noexcept;
+
+    // Takes effect from the next block, without a click: combs being dropped
+    // fade out over a few milliseconds, and combs coming back start silent.
+    void setNetworkSize (NetworkSize newSize) noexcept;
+    NetworkSize getNetworkSize() const noexcept { return networkSize; }
+
+    // Clears the tail and jumps any parameter smoothing to its target.
+    void reset() noexcept;
+
+    void setParameters (const Parameters& newParameters) noexcept;
+    const Parameters& getParameters() const noexcept { return parameters; }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numInputChannels = inputBlock.getNumChannels();
+        const auto numOutputChannels = outputBlock.getNumChannels();
+        const auto numSamples = (int) outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumSamples() == (size_t) numSamples);
+        outputBlock.copyFrom (inputBlock);
+
+        if (context.isBypassed || currentSampleRate <= 0.0)
+            return;
+
+        if (numInputChannels == (size_t) preparedChannels && numOutputChannels == (size_t) preparedChannels)
+            (this->*processNetwork) (outputBlock.getChannelPointer (0),
+                                     outputBlock.getChannelPointer ((size_t) preparedChannels - 1), numSamples);
+        else
+            jassertfalse; // the layout must match the one prepared
+    }
+
+    // Memory is reserved for at least this rate on the first prepare, so
+    // later rate changes up to it never allocate.
+    static constexpr double maximumSampleRate = 192000.0;
+
+private:
+    static constexpr int maximumChannels = 2;
+    static constexpr int numCombs = 8;
+    static constexpr int numAllPasses = 4;
+
+    struct AllPassFilter
+    {
+        float* buffer = nullptr;
+        int size = 0;
+        int index = 0;
+
+        float process (float input) noexcept
+        {
+            const auto bufferedValue = buffer[index];
+            auto temp = input + (bufferedValue * 0.5f);
+            JUCE_UNDENORMALISE (temp);
+            buffer[index] = temp;
+
+            if (++index >= size)
+                index = 0;
+
+            return bufferedValue - input;
+        }
+    };
+
+    static size_t getRequiredMemory (double sampleRate) noexcept;
+    void setDelayLengths (double sampleRate) noexcept;
+    void updateDamping() noexcept;
+    void selectNetwork() noexcept;
+    void clearUpperCombs() noexcept;
+    void fadeOutUpperCombs (int numChannels, const float* input, const float* damp, const float* feedbackLevel,
+                            float* outLeft, float* outRight, int numSamples) noexcept;
+
+    template <int numChannels, int combsPerChannel>
+    void processChannels (float* left, float* right, int numSamples) noexcept;
+
+    using NetworkFunction = void (ReverbEngine::*) (float*, float*, int) noexcept;
+
+    // Parameter smoothing is stepped into per-sample arrays a chunk at a
+    // time, so the kernels see plain buffers.
+    static constexpr int chunkSize = 64;
+
+    DspKernels::CombBank combs;
+    std::array<std::array<AllPassFilter, numAllPasses>, maximumChannels> allPasses;
+    const DspKernels::Kernels* kernels = &DspKernels::getKernels (DspKernels::InstructionSet::scalar);
+    NetworkFunction processNetwork = nullptr;
+    DspKernels::CombFunction processCombs = nullptr;
+    NetworkSize networkSize = NetworkSize::full;
+    int preparedChannels = 0;
+    int upperCombsFadeLength = 1;
+    int upperCombsFadeRemaining = 0;
+
+    juce::HeapBlock<float> memory;
+    size_t memoryCapacity = 0;
+    size_t memoryInUse = 0;
+
+    juce::SmoothedValue<float> damping, feedback, dryGain, wetGain1, wetGain2, networkGain;
+    float gain = 0.0f;
+    Parameters parameters;
+    double currentSampleRate = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReverbEngine)
+};
@@ -0,0 +1,127 @@
+#include "ReverbSettings.h"
+
+ReverbSettings ReverbSettings::fromParameters (const juce::AudioProcessorValueTreeState& apvts)
+{
+    auto read = [&apvts] (const char* id, float fallback)
+    {
+        auto* value = apvts.getRawParameterValue (id);
+        return value != nullptr ? value->load() : fallback;
+    };
+
+    ReverbSettings settings;
+    settings.roomSize = read ("ROOMSIZE", settings.roomSize);
+    settings.decay = read ("DECAY", settings.decay);
+    settings.preDelay = read ("PREDELAY", settings.preDelay);
+    settings.damping = read ("DAMPING", settings.damping);
+    settings.mix = read ("MIX", settings.mix);
+    settings.width = read ("WIDTH", settings.width);
+    settings.lowCut = read ("LOWCUT", settings.lowCut);
+    settings.highCut = read ("HIGHCUT", settings.highCut);
+    settings.engine = juce::roundToInt (read ("ENGINE", (float) settings.engine));
+    return settings;
+}
+
+void ReverbSettings::applyTo (juce::AudioProcessorValueTreeState& apvts) const
+{
+    auto write = [&apvts] (const char* id, float value)
+    {
+        if (auto* parameter = apvts.getParameter (id))
+            parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    };
+
+    write ("ROOMSIZE", roomSize);
+    write ("DECAY", decay);
+    write ("PREDELAY", preDelay);
+    write ("DAMPING", damping);
+    write ("MIX", mix);
+    write ("WIDTH", width);
+    write ("LOWCUT", lowCut);
+    write ("HIGHCUT", highCut);
+}
+
+juce::uint64 ReverbSettings::getTailHash() const noexcept
+{
+    // FNV-1a over the bit patterns of the parameters the tail depends on.
+    juce::uint64 hash = 14695981039346656037ull;
+    const auto tailDecay = engine == engineClassic ? 0.0f : decay;
+
+    for (auto value : { (float) engine, roomSize, tailDecay, damping, width })
+    {
+        juce::uint32 bits;
+        std::memcpy (&bits, &value, sizeof (bits));
+
+        for (int byte = 0; byte < 4; ++byte)
+        {
+            hash ^= (bits >> (byte * 8)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+
+    return hash;
+}
+
+juce::Reverb::Parameters ReverbSettings::toWetReverbParameters() const noexcept
+{
+    auto params = toReverbParameters();
+    params.wetLevel = 1.0f;
+    return params;
+}
+
+SpectralEngine::Parameters ReverbSettings::toWetSpectralParameters() const noexcept
+{
+    SpectralEngine::Parameters params;
+    params.decaySeconds = decay;
+    params.dampingHz = dampingToCutoffHz (damping);
+    params.roomSize = normaliseRoomSize (roomSize);
+    params.wetLevel = 1.0f;
+    params.width = normaliseWidth (width);
+    return params;
+}
+
+VelvetEngine::Parameters ReverbSettings::toWetVelvetParameters() const noexcept
+{
+    VelvetEngine::Parameters params;
+    params.dampingHz = dampingToCutoffHz (damping);
+    params.wetLevel = 1.0f;
+    params.width = normaliseWidth (width);
+    return params;
+}
+
+juce::Reverb::Parameters ReverbSettings::toReverbParameters() const noexcept
+{
+    juce::Reverb::Parameters params;
+    params.roomSize = normaliseRoomSize (roomSize);
+    params.damping = normaliseDamping (damping);
+    params.wetLevel = normaliseMix (mix);
+    params.dryLevel = 0.0f;
+    params.width = normaliseWidth (width);
+    params.freezeMode = false;
+    return params;
+}
+
+float ReverbSettings::normaliseRoomSize (float roomSizePercent) noexcept
+{
+    return juce::jlimit (0.0f, 1.0f, roomSizePercent / 100.0f);
+}
+
+float ReverbSettings::normaliseDamping (float dampingHz) noexcept
+{
+    auto dampingNorm = (std::log (dampingHz) - std::log (1000.0f))
+                       / (std::log (20000.0f) - std::log (1000.0f));
+    return juce::jlimit (0.0f, 1.0f, dampingNorm);
+}
+
+float ReverbSettings::dampingToCutoffHz (float dampingHz) noexcept
+{
+    return 1000.0f * 20000.0f / juce::jlimit (1000.0f, 20000.0f, dampingHz);
+}
+
+float ReverbSettings::normaliseWidth (float widthPercent) noexcept
+{
+    return juce::jlimit (0.0f, 1.0f, widthPercent / 200.0f);
+}
+
+float ReverbSettings::normaliseMix (float mixPercent) noexcept
+{
+    return juce::jlimit (0.0f, 1.0f, mixPercent / 100.0f);
+}
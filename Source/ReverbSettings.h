@@ -0,0 +1,52 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectralEngine.h"
+#include "VelvetEngine.h"
+
+// A snapshot of the parameters that shape the reverb, plus the mapping from
+// their user-facing ranges onto the engine. Shared by the processor and
+// anything that renders the engine outside the audio thread.
+struct ReverbSettings
+{
+    float roomSize = 50.0f;
+    float decay = 2.5f;
+    float preDelay = 20.0f;
+    float damping = 8000.0f;
+    float mix = 30.0f;
+    float width = 100.0f;
+    float lowCut = 20.0f;
+    float highCut = 12000.0f;
+
+    // The ENGINE choice index. Presets keep whatever engine is selected, so
+    // applyTo() leaves it alone.
+    static constexpr int engineClassic = 0, engineSpectral = 1, engineVelvet = 2;
+    int engine = engineClassic;
+
+    static ReverbSettings fromParameters (const juce::AudioProcessorValueTreeState& apvts);
+    void applyTo (juce::AudioProcessorValueTreeState& apvts) const;
+
+    // Hashes exactly what the selected engine's tail depends on. Mix,
+    // pre-delay and the output filters are applied after the tail, so they
+    // are left out, as is DECAY for the classic engine, which ignores it.
+    juce::uint64 getTailHash() const noexcept;
+
+    // The engine parameters at full wet level, for rendering the tail alone.
+    juce::Reverb::Parameters toWetReverbParameters() const noexcept;
+    SpectralEngine::Parameters toWetSpectralParameters() const noexcept;
+    VelvetEngine::Parameters toWetVelvetParameters() const noexcept;
+
+    // The engine configuration used by the processor, with the mix as the
+    // wet level and the dry signal added separately.
+    juce::Reverb::Parameters toReverbParameters() const noexcept;
+
+    static float normaliseRoomSize (float roomSizePercent) noexcept;
+    static float normaliseDamping (float dampingHz) noexcept;
+
+    // DAMPING darkens the tail as it rises in every engine. The engines that
+    // take a low-pass cutoff get it mirrored on the log scale, so 1 kHz of
+    // damping is a 20 kHz cutoff and 20 kHz of damping a 1 kHz one.
+    static float dampingToCutoffHz (float dampingHz) noexcept;
+    static float normaliseWidth (float widthPercent) noexcept;
+    static float normaliseMix (float mixPercent) noexcept;
+};
@@ -0,0 +1,267 @@
+#include "SpectralEngine.h"
+
+SpectralEngine::SpectralEngine()
+{
+    setParameters ({});
+}
+
+int SpectralEngine::getOrderForSampleRate (double sampleRate) noexcept
+{
+    // Keeps the frame near 43 ms, fine enough in time for transients to
+    // blur into the tail rather than smear ahead of it.
+    auto order = minimumOrder;
+
+    while (order < maximumOrder && sampleRate > 50000.0 * (double) (1 << (order - minimumOrder)))
+        ++order;
+
+    return order;
+}
+
+void SpectralEngine::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    jassert (spec.sampleRate > 0.0);
+    jassert (spec.numChannels <= (juce::uint32) maximumChannels);
+
+    if (spec.sampleRate == currentSampleRate)
+        return;
+
+    if (memory == nullptr)
+    {
+        kernels = &DspKernels::getBestKernels();
+
+        for (size_t i = 0; i < ffts.size(); ++i)
+            ffts[i] = std::make_unique<juce::dsp::FFT> (minimumOrder + (int) i);
+
+        const auto perChannel = (size_t) (4 * maximumSize + maximumBins);
+        const auto shared = (size_t) (maximumSize + 2 * maximumBins);
+        memory.allocate (perChannel * maximumChannels + shared, true);
+        seedMemory.allocate ((size_t) (maximumBins * maximumChannels), true);
+
+        auto* next = memory.get();
+
+        for (size_t channel = 0; channel < channels.size(); ++channel)
+        {
+            auto& c = channels[channel];
+            c.input = next;   next += maximumSize;
+            c.output = next;  next += maximumSize;
+            c.frame = next;   next += 2 * maximumSize;
+            c.energy = next;  next += maximumBins;
+            c.seeds = seedMemory.get() + channel * (size_t) maximumBins;
+        }
+
+        window = next;      next += maximumSize;
+        energyDecay = next; next += maximumBins;
+        inputGain = next;
+    }
+
+    const auto order = getOrderForSampleRate (spec.sampleRate);
+    fft = ffts[(size_t) (order - minimumOrder)].get();
+    fftSize = 1 << order;
+    hopSize = fftSize / overlap;
+    numBins = fftSize / 2 + 1;
+    currentSampleRate = spec.sampleRate;
+
+    // Hann analysis and synthesis windows.
+    for (int i = 0; i < fftSize; ++i)
+        window[i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) fftSize);
+
+    wetGain1.reset (spec.sampleRate, 0.01);
+    wetGain2.reset (spec.sampleRate, 0.01);
+
+    coefficientsNeedUpdate = true;
+    reset();
+}
+
+void SpectralEngine::reset() noexcept
+{
+    if (fftSize == 0)
+        return;
+
+    for (size_t channel = 0; channel < channels.size(); ++channel)
+    {
+        auto& c = channels[channel];
+        juce::FloatVectorOperations::clear (c.input, fftSize);
+        juce::FloatVectorOperations::clear (c.output, fftSize);
+        juce::FloatVectorOperations::clear (c.frame, 2 * fftSize);
+        juce::FloatVectorOperations::clear (c.energy, numBins);
+
+        // Distinct phase sequences per channel decorrelate the two sides. The
+        // xorshift behind them needs a non-zero seed.
+        for (int bin = 0; bin < numBins; ++bin)
+            c.seeds[bin] = ((juce::uint32) (bin + 1) * 2654435761u + (juce::uint32) channel * 40503u) | 1u;
+    }
+
+    hopPosition = 0;
+    numStages = 0;
+    stagesDone = 0;
+    wetGain1.setCurrentAndTargetValue (wetGain1.getTargetValue());
+    wetGain2.setCurrentAndTargetValue (wetGain2.getTargetValue());
+}
+
+void SpectralEngine::setParameters (const Parameters& newParameters) noexcept
+{
+    // Roughly the classic engine's level on sustained material.
+    const auto wetScaleFactor = 0.5f;
+
+    const auto wet = newParameters.wetLevel * wetScaleFactor;
+    wetGain1.setTargetValue (0.5f * wet * (1.0f + newParameters.width));
+    wetGain2.setTargetValue (0.5f * wet * (1.0f - newParameters.width));
+
+    if (newParameters.decaySeconds != parameters.decaySeconds || newParameters.dampingHz != parameters.dampingHz
+        || newParameters.roomSize != parameters.roomSize || newParameters.freeze != parameters.freeze)
+        coefficientsNeedUpdate = true;
+
+    parameters = newParameters;
+}
+
+void SpectralEngine::updateCoefficients() noexcept
+{
+    coefficientsNeedUpdate = false;
+
+    if (parameters.freeze)
+    {
+        juce::FloatVectorOperations::fill (energyDecay, 1.0f, numBins);
+        juce::FloatVectorOperations::clear (inputGain, numBins);
+        return;
+    }
+
+    // Energy falls by 60 dB over the decay time, which shortens above the
+    // damping frequency like air absorption.
+    const auto roomScale = 0.25f + (maximumRoomScale - 0.25f) * juce::square (parameters.roomSize);
+    const auto decaySeconds = juce::jmax (0.01f, parameters.decaySeconds * roomScale);
+    const auto framesPerSecond = (float) (currentSampleRate / hopSize);
+    const auto binWidth = (float) (currentSampleRate / fftSize);
+    const auto logSixtyDb = std::log (1.0e-6f);
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        const auto ratio = (float) bin * binWidth / parameters.dampingHz;
+        const auto binDecaySeconds = decaySeconds / (1.0f + ratio * ratio);
+        energyDecay[bin] = std::exp (logSixtyDb / (framesPerSecond * binDecaySeconds));
+
+        // Feeds the input in so the steady state sits at the input's power
+        // whatever the decay time.
+        inputGain[bin] = 1.0f - energyDecay[bin];
+    }
+}
+
+void SpectralEngine::startHop (int numChannels) noexcept
+{
+    if (coefficientsNeedUpdate)
+        updateCoefficients();
+
+    // The random-phase frames overlap incoherently; this scaling leaves a
+    // steady input at its own power after windowing twice.
+    const auto synthesisScale = 4.0f / 3.0f;
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        auto& channel = channels[(size_t) i];
+
+        // Drop the hop just played and add the frame finished during it.
+        std::memmove (channel.output, channel.output + hopSize, sizeof (float) * (size_t) (fftSize - hopSize));
+        juce::FloatVectorOperations::clear (channel.output + (fftSize - hopSize), hopSize);
+        juce::FloatVectorOperations::addWithMultiply (channel.output, channel.frame, synthesisScale, fftSize);
+
+        // Take the next frame, and slide the input along by one hop.
+        juce::FloatVectorOperations::multiply (channel.frame, channel.input, window, fftSize);
+        std::memmove (channel.input, channel.input + hopSize, sizeof (float) * (size_t) (fftSize - hopSize));
+    }
+
+    numStages = 2 * numChannels;
+    stagesDone = 0;
+}
+
+void SpectralEngine::runStage (int stage) noexcept
+{
+    auto& channel = channels[(size_t) (stage / 2)];
+    auto* frame = channel.frame;
+
+    if (stage % 2 == 0)
+    {
+        fft->performRealOnlyForwardTransform (frame, true);
+
+        // Each bin's power feeds its energy, and the bin is replaced by that
+        // energy at a fresh random phase, in one vectorised pass.
+        kernels->resynthesiseBins (frame, channel.energy, channel.seeds, energyDecay, inputGain, numBins);
+
+        frame[1] = 0.0f;
+        frame[2 * (numBins - 1) + 1] = 0.0f;
+    }
+    else
+    {
+        fft->performRealOnlyInverseTransform (frame);
+        juce::FloatVectorOperations::multiply (frame, window, fftSize);
+    }
+}
+
+void SpectralEngine::writeInput (const float* samples, int channel, int numSamples) noexcept
+{
+    juce::FloatVectorOperations::copy (channels[(size_t) channel].input + (fftSize - hopSize + hopPosition), samples, numSamples);
+}
+
+void SpectralEngine::advance (int numSamples, int numChannels) noexcept
+{
+    hopPosition += numSamples;
+
+    if (hopPosition >= hopSize)
+    {
+        // Blocks longer than a stage's share leave work for the boundary.
+        while (stagesDone < numStages)
+            runStage (stagesDone++);
+
+        hopPosition = 0;
+        startHop (numChannels);
+    }
+
+    // Each stage runs once the hop is its share of the way through.
+    while (stagesDone < numStages && hopPosition * numStages >= stagesDone * hopSize)
+        runStage (stagesDone++);
+}
+
+void SpectralEngine::processMono (float* samples, int numSamples) noexcept
+{
+    for (int start = 0; start < numSamples;)
+    {
+        const auto count = juce::jmin (hopSize - hopPosition, numSamples - start);
+        auto* out = samples + start;
+        const auto* wet = channels[0].output + hopPosition;
+
+        writeInput (out, 0, count);
+
+        for (int i = 0; i < count; ++i)
+        {
+            wetGain2.getNextValue();
+            out[i] = wet[i] * wetGain1.getNextValue();
+        }
+
+        advance (count, 1);
+        start += count;
+    }
+}
+
+void SpectralEngine::processStereo (float* left, float* right, int numSamples) noexcept
+{
+    for (int start = 0; start < numSamples;)
+    {
+        const auto count = juce::jmin (hopSize - hopPosition, numSamples - start);
+        auto* outLeft = left + start;
+        auto* outRight = right + start;
+        const auto* wetLeft = channels[0].output + hopPosition;
+        const auto* wetRight = channels[1].output + hopPosition;
+
+        writeInput (outLeft, 0, count);
+        writeInput (outRight, 1, count);
+
+        for (int i = 0; i < count; ++i)
+        {
+            const auto wet1 = wetGain1.getNextValue();
+            const auto wet2 = wetGain2.getNextValue();
+            outLeft[i] = wetLeft[i] * wet1 + wetRight[i] * wet2;
+            outRight[i] = wetRight[i] * wet1 + wetLeft[i] * wet2;
+        }
+
+        advance (count, 2);
+        start += count;
+    }
+}
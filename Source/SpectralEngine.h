@@ -0,0 +1,125 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "DspKernels.h"
+
+// A spectral reverb: an overlapped STFT where every bin keeps a decaying
+// energy envelope fed by the input, resynthesised each frame with random
+// phases. Decay and damping only change per-bin coefficients, so the cost
+// and memory are the same for a 0.1 s tail as for a 30 s one.
+//
+// Each frame's transforms are spread over the following hop, a forward or
+// inverse transform for one channel at a time, so small blocks each carry a
+// similar share of the work instead of one block in every hop taking it
+// all. The frame is added a hop later for it; with the frame itself that is
+// about three quarters of a frame of latency on the wet path, heard as
+// pre-delay.
+//
+// All memory is reserved on the first prepare for the largest frame used at
+// any supported sample rate, so later rate changes never allocate.
+class SpectralEngine
+{
+public:
+    struct Parameters
+    {
+        float decaySeconds = 2.5f;
+        // A low-pass cutoff: higher is brighter. The processor maps DAMPING
+        // onto it through ReverbSettings::dampingToCutoffHz.
+        float dampingHz = 2500.0f;
+        float roomSize = 0.5f;
+        float wetLevel = 0.3f;
+        float width = 1.0f;
+        bool freeze = false;
+    };
+
+    SpectralEngine();
+
+    void prepare (const juce::dsp::ProcessSpec& spec);
+
+    // Clears the tail and jumps any parameter smoothing to its target.
+    void reset() noexcept;
+
+    // New coefficients take effect at the next frame boundary.
+    void setParameters (const Parameters& newParameters) noexcept;
+
+    // Writes the wet signal over the input, like ReverbEngine with no dry level.
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = (int) outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumSamples() == (size_t) numSamples);
+        outputBlock.copyFrom (inputBlock);
+
+        if (context.isBypassed || fftSize == 0)
+            return;
+
+        if (numChannels == 1)
+            processMono (outputBlock.getChannelPointer (0), numSamples);
+        else if (numChannels == 2)
+            processStereo (outputBlock.getChannelPointer (0), outputBlock.getChannelPointer (1), numSamples);
+        else
+            jassertfalse; // only mono and stereo are supported
+    }
+
+    // Room size stretches DECAY by up to this factor.
+    static constexpr float maximumRoomScale = 3.0f;
+    static constexpr double maximumSampleRate = 192000.0;
+
+private:
+    static constexpr int maximumChannels = 2;
+    static constexpr int minimumOrder = 11;
+    static constexpr int maximumOrder = 13;
+    static constexpr int maximumSize = 1 << maximumOrder;
+    static constexpr int maximumBins = maximumSize / 2 + 1;
+    static constexpr int overlap = 4;
+
+    struct Channel
+    {
+        float* input = nullptr;   // the last fftSize input samples
+        float* output = nullptr;  // overlap-add accumulator, read one hop at a time
+        float* frame = nullptr;   // the frame being transformed during this hop
+        float* energy = nullptr;  // per-bin decaying power
+        juce::uint32* seeds = nullptr; // per-bin random phase state
+    };
+
+    static int getOrderForSampleRate (double sampleRate) noexcept;
+    void updateCoefficients() noexcept;
+    void startHop (int numChannels) noexcept;
+    void runStage (int stage) noexcept;
+    void writeInput (const float* samples, int channel, int numSamples) noexcept;
+    void processMono (float* samples, int numSamples) noexcept;
+    void processStereo (float* left, float* right, int numSamples) noexcept;
+    void advance (int numSamples, int numChannels) noexcept;
+
+    std::array<std::unique_ptr<juce::dsp::FFT>, (size_t) (maximumOrder - minimumOrder + 1)> ffts;
+    juce::dsp::FFT* fft = nullptr;
+
+    std::array<Channel, (size_t) maximumChannels> channels;
+    juce::HeapBlock<float> memory;
+    juce::HeapBlock<juce::uint32> seedMemory;
+    float* window = nullptr;
+    float* energyDecay = nullptr;
+    float* inputGain = nullptr;
+
+    const DspKernels::Kernels* kernels = &DspKernels::getKernels (DspKernels::InstructionSet::scalar);
+
+    int fftSize = 0;
+    int hopSize = 0;
+    int numBins = 0;
+    int hopPosition = 0;
+    double currentSampleRate = 0.0;
+
+    // Forward then inverse transform per channel, run as the hop goes by.
+    int numStages = 0;
+    int stagesDone = 0;
+
+    Parameters parameters;
+    bool coefficientsNeedUpdate = true;
+    juce::SmoothedValue<float> wetGain1, wetGain2;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectralEngine)
+};
@@ -0,0 +1,129 @@
+#include "StageProfiler.h"
+
+#if OBSIDIAN_ENABLE_PROFILING
+
+namespace
+{
+    std::atomic<int> nextInstanceId { 1 };
+}
+
+StageProfiler::StageProfiler()
+    : juce::Thread ("Obsidian Space Profiler"),
+      instanceId (nextInstanceId.fetch_add (1)),
+      originTicks (juce::Time::getHighResolutionTicks()),
+      microsecondsPerTick (1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond())
+{
+    auto file = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                    .getNonexistentChildFile ("ObsidianSpaceTrace-" + juce::String (instanceId), ".json", false);
+    output = file.createOutputStream();
+
+    if (output != nullptr && output->openedOk())
+    {
+        *output << "{\"traceEvents\":[\n";
+        DBG ("Obsidian Space profiler writing to " + file.getFullPathName());
+        startThread (juce::Thread::Priority::background);
+    }
+    else
+    {
+        output.reset();
+    }
+}
+
+StageProfiler::~StageProfiler()
+{
+    stopThread (2000);
+
+    if (output != nullptr)
+    {
+        drain();
+        *output << "\n],\"otherData\":{\"droppedRecords\":" << (int) droppedRecords.load() << "}}\n";
+        output->flush();
+    }
+}
+
+void StageProfiler::prepare (double sampleRate)
+{
+    currentSampleRate.store (sampleRate, std::memory_order_relaxed);
+}
+
+void StageProfiler::addRecord (DspStage stage, juce::int64 startTicks, juce::int64 endTicks, int numSamples) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    if (size1 + size2 == 0)
+    {
+        droppedRecords.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring[(size_t) start1] = { startTicks, endTicks, (juce::int32) numSamples, stage };
+    fifo.finishedWrite (1);
+}
+
+void StageProfiler::run()
+{
+    while (! threadShouldExit())
+    {
+        drain();
+        wait (100);
+    }
+}
+
+void StageProfiler::drain()
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+    if (size1 + size2 == 0)
+        return;
+
+    const auto sampleRate = currentSampleRate.load (std::memory_order_relaxed);
+    juce::String events;
+
+    if (isFirstEvent)
+    {
+        events << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << instanceId
+               << ",\"args\":{\"name\":\"Obsidian Space #" << instanceId << "\"}}";
+        isFirstEvent = false;
+    }
+
+    auto appendRecords = [&] (int start, int size)
+    {
+        for (int i = start; i < start + size; ++i)
+        {
+            const auto& record = ring[(size_t) i];
+            events << ",\n{\"name\":\"" << getStageName (record.stage)
+                   << "\",\"cat\":\"dsp\",\"ph\":\"X\",\"pid\":1,\"tid\":" << instanceId
+                   << ",\"ts\":" << juce::String ((double) (record.startTicks - originTicks) * microsecondsPerTick, 3)
+                   << ",\"dur\":" << juce::String ((double) (record.endTicks - record.startTicks) * microsecondsPerTick, 3)
+                   << ",\"args\":{\"samples\":" << (int) record.numSamples
+                   << ",\"sampleRate\":" << sampleRate << "}}";
+        }
+    };
+
+    appendRecords (start1, size1);
+    appendRecords (start2, size2);
+    fifo.finishedRead (size1 + size2);
+
+    *output << events;
+    output->flush();
+}
+
+const char* StageProfiler::getStageName (DspStage stage) noexcept
+{
+    switch (stage)
+    {
+        case DspStage::block:           return "processBlock";
+        case DspStage::parameterUpdate: return "parameter update";
+        case DspStage::reverbTail:      return "reverb tail";
+        case DspStage::outputMix:       return "output mix";
+        case DspStage::pipelineHandoff: return "pipeline handoff";
+        case DspStage::numStages:
+        default:                        break;
+    }
+
+    return "unknown";
+}
+
+#endif
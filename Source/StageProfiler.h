@@ -0,0 +1,97 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Build with OBSIDIAN_ENABLE_PROFILING=1 to record per-stage timings of
+// processBlock into a Chrome / Perfetto trace file in the temp directory.
+// When it is 0 (the default) the profiler and its macros compile to nothing.
+#ifndef OBSIDIAN_ENABLE_PROFILING
+ #define OBSIDIAN_ENABLE_PROFILING 0
+#endif
+
+enum class DspStage : juce::uint8
+{
+    block,
+    parameterUpdate,
+    reverbTail,
+    outputMix,
+    pipelineHandoff,
+    numStages
+};
+
+#if OBSIDIAN_ENABLE_PROFILING
+
+class StageProfiler : private juce::Thread
+{
+public:
+    StageProfiler();
+    ~StageProfiler() override;
+
+    void prepare (double sampleRate);
+
+    // Audio thread only. Drops the record if the writer has fallen behind.
+    void addRecord (DspStage stage, juce::int64 startTicks, juce::int64 endTicks, int numSamples) noexcept;
+
+    class ScopedStage
+    {
+    public:
+        ScopedStage (StageProfiler& profilerToUse, DspStage stageToTime, int numSamplesInBlock) noexcept
+            : profiler (profilerToUse),
+              stage (stageToTime),
+              numSamples (numSamplesInBlock),
+              startTicks (juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedStage() noexcept
+        {
+            profiler.addRecord (stage, startTicks, juce::Time::getHighResolutionTicks(), numSamples);
+        }
+
+    private:
+        StageProfiler& profiler;
+        const DspStage stage;
+        const int numSamples;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedStage)
+    };
+
+private:
+    struct Record
+    {
+        juce::int64 startTicks;
+        juce::int64 endTicks;
+        juce::int32 numSamples;
+        DspStage stage;
+    };
+
+    void run() override;
+    void drain();
+    static const char* getStageName (DspStage stage) noexcept;
+
+    static constexpr int ringSize = 1 << 15;
+
+    juce::AbstractFifo fifo { ringSize };
+    std::vector<Record> ring = std::vector<Record> ((size_t) ringSize);
+    std::atomic<double> currentSampleRate { 0.0 };
+    std::atomic<juce::uint32> droppedRecords { 0 };
+
+    const int instanceId;
+    const juce::int64 originTicks;
+    const double microsecondsPerTick;
+
+    std::unique_ptr<juce::FileOutputStream> output;
+    bool isFirstEvent = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StageProfiler)
+};
+
+ #define OBSIDIAN_PROFILE_STAGE(profiler, stage, numSamples) \
+    StageProfiler::ScopedStage JUCE_JOIN_MACRO (profiledStage, __LINE__) (profiler, stage, numSamples)
+
+#else
+
+ #define OBSIDIAN_PROFILE_STAGE(profiler, stage, numSamples)
+
+#endif
@@ -0,0 +1,491 @@
+#include "VelvetEngine.h"
+
+namespace
+{
+    // Impulses per second, summed over the lines.
+    constexpr float density = 1500.0f;
+
+    // Loop lengths with no simple ratio between them, so the lines never
+    // repeat in step.
+    constexpr std::array<float, 3> loopSeconds { 0.0971f, 0.1213f, 0.1437f };
+
+    // The gap before the first tap, growing with ROOMSIZE.
+    constexpr float minimumOnsetSeconds = 0.002f;
+    constexpr float onsetSecondsPerRoom = 0.03f;
+
+    // The T60 the loop low-passes alone give at the DAMPING cutoff. Being a
+    // fixed time, longer tails lose their highs relatively sooner, as they
+    // would to air absorption.
+    constexpr float dampingSeconds = 2.0f;
+}
+
+//==============================================================================
+VelvetTableBuilder::VelvetTableBuilder()
+    : juce::Thread ("Obsidian Space Velvet Tables")
+{
+    startThread (juce::Thread::Priority::low);
+}
+
+VelvetTableBuilder::~VelvetTableBuilder()
+{
+    stopThread (2000);
+}
+
+void VelvetTableBuilder::request (VelvetEngine& engine)
+{
+    {
+        const juce::ScopedLock sl (lock);
+        pending.addIfNotAlreadyThere (&engine);
+    }
+
+    notify();
+}
+
+void VelvetTableBuilder::cancel (VelvetEngine& engine)
+{
+    for (;;)
+    {
+        {
+            const juce::ScopedLock sl (lock);
+            pending.removeAllInstancesOf (&engine);
+
+            if (building != &engine)
+                return;
+        }
+
+        buildFinished.wait (10);
+    }
+}
+
+void VelvetTableBuilder::run()
+{
+    while (! threadShouldExit())
+    {
+        VelvetEngine* engine = nullptr;
+
+        {
+            const juce::ScopedLock sl (lock);
+
+            if (! pending.isEmpty())
+            {
+                engine = pending.removeAndReturn (0);
+                building = engine;
+            }
+        }
+
+        if (engine == nullptr)
+        {
+            wait (-1);
+            continue;
+        }
+
+        engine->buildPendingTable();
+
+        {
+            const juce::ScopedLock sl (lock);
+            building = nullptr;
+        }
+
+        buildFinished.signal();
+    }
+}
+
+//==============================================================================
+VelvetEngine::VelvetEngine()
+{
+    for (auto& state : tableStates)
+        state.store (TableState::free);
+
+    setParameters ({});
+}
+
+VelvetEngine::~VelvetEngine()
+{
+    builder->cancel (*this);
+}
+
+void VelvetEngine::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    jassert (spec.sampleRate > 0.0);
+    jassert (spec.numChannels <= (juce::uint32) maximumChannels);
+
+    if (spec.sampleRate == currentSampleRate)
+        return;
+
+    builder->cancel (*this);
+
+    for (int line = 0; line < numLines; ++line)
+        loopLengths[(size_t) line] = getLoopLength (line, spec.sampleRate);
+
+    // Long enough for the furthest tap over a whole chunk; the last line is
+    // the longest. The history only grows, so returning to a lower rate
+    // never allocates.
+    historySize = (int) std::ceil ((minimumOnsetSeconds + onsetSecondsPerRoom) * spec.sampleRate)
+                + loopLengths.back() + chunkSize + 1;
+
+    if (historySize * numLines > historyCapacity)
+    {
+        history.allocate ((size_t) (historySize * numLines), false);
+        historyCapacity = historySize * numLines;
+    }
+
+    currentSampleRate = spec.sampleRate;
+    resetTables();
+
+    wetGain1.reset (spec.sampleRate, 0.01);
+    wetGain2.reset (spec.sampleRate, 0.01);
+    updateFilters();
+    reset();
+}
+
+void VelvetEngine::reset() noexcept
+{
+    writePosition = 0;
+    validSamples = 0;
+
+    loopStates.fill (0.0f);
+
+    wetGain1.setCurrentAndTargetValue (wetGain1.getTargetValue());
+    wetGain2.setCurrentAndTargetValue (wetGain2.getTargetValue());
+}
+
+void VelvetEngine::setParameters (const Parameters& newParameters) noexcept
+{
+    // Tables are normalised to unity power; this lands near the classic
+    // engine's level on sustained material.
+    const auto wetScaleFactor = 0.5f;
+
+    const auto wet = newParameters.wetLevel * wetScaleFactor;
+    wetGain1.setTargetValue (0.5f * wet * (1.0f + newParameters.width));
+    wetGain2.setTargetValue (0.5f * wet * (1.0f - newParameters.width));
+
+    const auto dampingChanged = newParameters.dampingHz != parameters.dampingHz;
+    parameters = newParameters;
+
+    if (dampingChanged)
+        updateFilters();
+}
+
+void VelvetEngine::requestTables (float decaySeconds, float roomSize)
+{
+    if (decaySeconds == requestedDecay.load() && roomSize == requestedRoomSize.load())
+        return;
+
+    requestedDecay.store (decaySeconds);
+    requestedRoomSize.store (roomSize);
+
+    if (currentSampleRate > 0.0)
+        builder->request (*this);
+}
+
+void VelvetEngine::buildTablesNow (float decaySeconds, float roomSize)
+{
+    jassert (currentSampleRate > 0.0);
+
+    builder->cancel (*this);
+    requestedDecay.store (decaySeconds);
+    requestedRoomSize.store (roomSize);
+    resetTables();
+    reset();
+}
+
+void VelvetEngine::resetTables()
+{
+    for (auto& state : tableStates)
+        state.store (TableState::free);
+
+    readyTable.store (-1);
+    fadingTable = -1;
+    liveTable = 0;
+    tableStates[0].store (TableState::live);
+
+    builtDecay = requestedDecay.load();
+    builtRoomSize = requestedRoomSize.load();
+    generate (tables[0], currentSampleRate, builtDecay, builtRoomSize);
+}
+
+void VelvetEngine::updateFilters() noexcept
+{
+    if (currentSampleRate <= 0.0)
+        return;
+
+    // Solves each one-pole for the gain at the cutoff that gives a T60 of
+    // dampingSeconds over its loop length: |H|^2 = r^2, H = a / (1 - p/z).
+    const auto cosine = std::cos (juce::MathConstants<double>::twoPi
+                                  * juce::jmin ((double) parameters.dampingHz, currentSampleRate * 0.45) / currentSampleRate);
+
+    for (int line = 0; line < numLines; ++line)
+    {
+        const auto passes = (double) dampingSeconds * currentSampleRate / loopLengths[(size_t) line];
+        const auto r2 = std::pow (1.0e-3, 2.0 / passes);
+        const auto a = 1.0 - r2;
+        const auto b = 1.0 - r2 * cosine;
+        const auto pole = (b - std::sqrt (juce::jmax (0.0, b * b - a * a))) / a;
+        loopCoefficients[(size_t) line] = (float) (1.0 - pole);
+    }
+}
+
+//==============================================================================
+void VelvetEngine::generate (TapTable& table, double sampleRate, float decaySeconds, float roomSize)
+{
+    // Each line's segment starts after a gap that grows with the room and
+    // runs for one loop, weighted so the passes round the loop continue the
+    // envelope. A fixed seed keeps the pattern stable as DECAY moves, so
+    // swapping tables only changes the gains.
+    const auto t60 = juce::jlimit (0.1f, maximumTailSeconds, decaySeconds * (0.5f + roomSize));
+    const auto onset = juce::roundToInt ((minimumOnsetSeconds + onsetSecondsPerRoom * roomSize) * sampleRate);
+    const auto period = numLines * sampleRate / density;
+    const auto logSixtyDb = std::log (1.0e-3);
+
+    for (int line = 0; line < numLines; ++line)
+        table.loopGains[(size_t) line] = (float) std::exp (logSixtyDb * getLoopLength (line, sampleRate) / (sampleRate * t60));
+
+    for (size_t channel = 0; channel < table.channels.size(); ++channel)
+    {
+        auto& taps = table.channels[channel];
+        taps.delays.clear();
+        taps.gains.clear();
+
+        juce::Random random (0x0b5d1a40 + (juce::int64) channel);
+        double energy = 0.0;
+
+        for (int line = 0; line < numLines; ++line)
+        {
+            taps.lineStarts[(size_t) line] = (int) taps.delays.size();
+
+            const auto length = getLoopLength (line, sampleRate);
+            double lineEnergy = 0.0;
+
+            for (auto time = 0.0; time < length; time += period)
+            {
+                const auto delay = onset + juce::jmin (length - 1, (int) (time + random.nextDouble() * period));
+                const auto gain = (random.nextBool() ? 1.0f : -1.0f) * (float) std::exp (logSixtyDb * delay / (sampleRate * t60));
+
+                taps.delays.push_back (delay);
+                taps.gains.push_back (gain);
+                lineEnergy += (double) gain * gain;
+            }
+
+            // Every pass round the loop repeats the segment's energy, scaled
+            // by the loop gain squared.
+            const auto loopGain = (double) table.loopGains[(size_t) line];
+            energy += lineEnergy / (1.0 - loopGain * loopGain);
+        }
+
+        taps.lineStarts[(size_t) numLines] = (int) taps.delays.size();
+
+        // Near unity power gain on white noise, whatever the tail length.
+        if (energy > 0.0)
+            juce::FloatVectorOperations::multiply (taps.gains.data(), (float) (1.0 / std::sqrt (energy)), (int) taps.gains.size());
+    }
+}
+
+int VelvetEngine::getLoopLength (int line, double sampleRate) noexcept
+{
+    return juce::roundToInt (loopSeconds[(size_t) line] * sampleRate);
+}
+
+void VelvetEngine::buildPendingTable()
+{
+    const auto decay = requestedDecay.load();
+    const auto roomSize = requestedRoomSize.load();
+
+    if (decay == builtDecay && roomSize == builtRoomSize)
+        return;
+
+    for (int index = 0; index < numTables; ++index)
+    {
+        auto expected = TableState::free;
+
+        if (! tableStates[(size_t) index].compare_exchange_strong (expected, TableState::building, std::memory_order_acquire))
+            continue;
+
+        generate (tables[(size_t) index], currentSampleRate, decay, roomSize);
+        builtDecay = decay;
+        builtRoomSize = roomSize;
+
+        tableStates[(size_t) index].store (TableState::ready, std::memory_order_relaxed);
+
+        // A table the audio thread never picked up is simply superseded.
+        const auto superseded = readyTable.exchange (index, std::memory_order_acq_rel);
+
+        if (superseded >= 0)
+            tableStates[(size_t) superseded].store (TableState::free, std::memory_order_release);
+
+        return;
+    }
+
+    // With one table each live, fading, ready and building, there is always
+    // a free one.
+    jassertfalse;
+}
+
+//==============================================================================
+void VelvetEngine::takeReadyTable() noexcept
+{
+    const auto ready = readyTable.exchange (-1, std::memory_order_acq_rel);
+
+    if (ready < 0)
+        return;
+
+    tableStates[(size_t) ready].store (TableState::live, std::memory_order_relaxed);
+    tableStates[(size_t) liveTable].store (TableState::fading, std::memory_order_relaxed);
+    fadingTable = liveTable;
+    liveTable = ready;
+}
+
+void VelvetEngine::writeLines (const float* input, int numSamples) noexcept
+{
+    // New loop gains ramp in over the chunk, with the taps.
+    const auto& liveGains = tables[(size_t) liveTable].loopGains;
+    const auto& fadeGains = fadingTable >= 0 ? tables[(size_t) fadingTable].loopGains : liveGains;
+
+    std::array<float*, (size_t) numLines> lines;
+    std::array<int, (size_t) numLines> readPositions, firstFeedback;
+
+    for (size_t line = 0; line < (size_t) numLines; ++line)
+    {
+        lines[line] = history.get() + line * (size_t) historySize;
+        readPositions[line] = writePosition - loopLengths[line];
+
+        if (readPositions[line] < 0)
+            readPositions[line] += historySize;
+
+        // Loop reads reaching back before the last reset are silent.
+        firstFeedback[line] = juce::jlimit (0, numSamples, loopLengths[line] - validSamples);
+    }
+
+    auto states = loopStates;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto ramp = (float) (i + 1) / (float) numSamples;
+        std::array<float, (size_t) numLines> returns;
+        auto sum = 0.0f;
+
+        for (size_t line = 0; line < (size_t) numLines; ++line)
+        {
+            const auto delayed = i >= firstFeedback[line] ? lines[line][readPositions[line]] : 0.0f;
+            states[line] += loopCoefficients[line] * (delayed - states[line]);
+            returns[line] = states[line] * (fadeGains[line] + (liveGains[line] - fadeGains[line]) * ramp);
+            sum += returns[line];
+
+            if (++readPositions[line] >= historySize)
+                readPositions[line] = 0;
+        }
+
+        // The Householder reflection I - 2/N keeps the loop energy while
+        // sending every line into every other.
+        const auto reflection = sum * (2.0f / (float) numLines);
+
+        for (size_t line = 0; line < (size_t) numLines; ++line)
+            lines[line][writePosition] = input[i] + returns[line] - reflection;
+
+        if (++writePosition >= historySize)
+            writePosition = 0;
+    }
+
+    loopStates = states;
+    validSamples = juce::jmin (historySize, validSamples + numSamples);
+}
+
+void VelvetEngine::renderTaps (const TapTable& table, int channel, int start, int numSamples, float* sum) noexcept
+{
+    const auto& taps = table.channels[(size_t) channel];
+    juce::FloatVectorOperations::clear (sum, numSamples);
+
+    for (int line = 0; line < numLines; ++line)
+    {
+        const auto* input = history.get() + line * historySize;
+
+        for (auto tap = taps.lineStarts[(size_t) line]; tap < taps.lineStarts[(size_t) line + 1]; ++tap)
+        {
+            // Skip the part of the run written before the last reset. Taps
+            // are in delay order, so once a run is all stale so are the rest.
+            const auto delay = taps.delays[(size_t) tap];
+            const auto firstValid = juce::jmax (0, numSamples + delay - validSamples);
+
+            if (firstValid >= numSamples)
+                break;
+
+            auto readPosition = start - delay + firstValid;
+            if (readPosition < 0)
+                readPosition += historySize;
+
+            const auto gain = taps.gains[(size_t) tap];
+            const auto length = numSamples - firstValid;
+            const auto firstRun = juce::jmin (length, historySize - readPosition);
+            juce::FloatVectorOperations::addWithMultiply (sum + firstValid, input + readPosition, gain, firstRun);
+
+            if (firstRun < length)
+                juce::FloatVectorOperations::addWithMultiply (sum + firstValid + firstRun, input, gain, length - firstRun);
+        }
+    }
+}
+
+void VelvetEngine::processChannels (float* left, float* right, int numSamples) noexcept
+{
+    const auto numChannels = right != nullptr ? 2 : 1;
+
+    for (int start = 0; start < numSamples;)
+    {
+        const auto count = juce::jmin (chunkSize, numSamples - start);
+
+        // A new table crossfades in over one chunk.
+        if (fadingTable < 0)
+            takeReadyTable();
+
+        auto* input = chunkBuffers.getWritePointer (0);
+
+        for (int i = 0; i < count; ++i)
+            input[i] = right != nullptr ? 0.5f * (left[start + i] + right[start + i]) : left[start + i];
+
+        const auto chunkStart = writePosition;
+        writeLines (input, count);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* liveSum = chunkBuffers.getWritePointer (1 + channel);
+            renderTaps (tables[(size_t) liveTable], channel, chunkStart, count, liveSum);
+
+            if (fadingTable >= 0)
+            {
+                auto* fadeSum = chunkBuffers.getWritePointer (1 + maximumChannels + channel);
+                renderTaps (tables[(size_t) fadingTable], channel, chunkStart, count, fadeSum);
+
+                for (int i = 0; i < count; ++i)
+                    liveSum[i] = fadeSum[i] + (liveSum[i] - fadeSum[i]) * (float) (i + 1) / (float) count;
+            }
+        }
+
+        const auto* wetLeft = chunkBuffers.getReadPointer (1);
+        const auto* wetRight = chunkBuffers.getReadPointer (2);
+
+        if (right == nullptr)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                wetGain2.getNextValue();
+                left[start + i] = wetLeft[i] * wetGain1.getNextValue();
+            }
+        }
+        else
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                const auto wet1 = wetGain1.getNextValue();
+                const auto wet2 = wetGain2.getNextValue();
+                left[start + i] = wetLeft[i] * wet1 + wetRight[i] * wet2;
+                right[start + i] = wetRight[i] * wet1 + wetLeft[i] * wet2;
+            }
+        }
+
+        if (fadingTable >= 0)
+        {
+            tableStates[(size_t) fadingTable].store (TableState::free, std::memory_order_release);
+            fadingTable = -1;
+        }
+
+        start += count;
+    }
+}
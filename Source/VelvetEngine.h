@@ -0,0 +1,188 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+class VelvetEngine;
+
+// One low-priority thread per process rebuilds tap tables for every velvet
+// engine, so moving DECAY or ROOMSIZE never generates tables on an audio
+// thread. Shared through a SharedResourcePointer.
+class VelvetTableBuilder : private juce::Thread
+{
+public:
+    VelvetTableBuilder();
+    ~VelvetTableBuilder() override;
+
+    void request (VelvetEngine& engine);
+
+    // Drops any pending request and waits for a build in progress.
+    void cancel (VelvetEngine& engine);
+
+private:
+    void run() override;
+
+    juce::CriticalSection lock;
+    juce::Array<VelvetEngine*> pending;
+    VelvetEngine* building = nullptr;
+    juce::WaitableEvent buildFinished;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VelvetTableBuilder)
+};
+
+// A late tail made of velvet noise: sparse +-1 impulses on a jittered grid,
+// weighted by an exponential decay envelope. Only the non-zero taps are
+// evaluated, each as one multiply-add over a run of a delay line.
+//
+// The mono input feeds three recirculating lines of 97 to 144 ms, mixed
+// through a Householder matrix on every pass and damped by a one-pole
+// low-pass in each loop, so high frequencies die away first. Each output
+// channel has its own velvet segment on every line, one loop long, so the
+// recirculation carries it on for the rest of the tail. That keeps about
+// 180 taps per channel whatever the DECAY, where a tap per impulse over the
+// whole tail took about 700 at the default and 2800 at ten seconds.
+//
+// Tap tables depend on DECAY, ROOMSIZE and the sample rate. prepare() builds
+// them directly; later changes are built by the shared builder thread and
+// crossfaded in on the audio thread, along with their loop gains.
+class VelvetEngine
+{
+public:
+    struct Parameters
+    {
+        // A low-pass cutoff: higher is brighter. The processor maps DAMPING
+        // onto it through ReverbSettings::dampingToCutoffHz.
+        float dampingHz = 2500.0f;
+        float wetLevel = 0.3f;
+        float width = 1.0f;
+    };
+
+    VelvetEngine();
+    ~VelvetEngine();
+
+    // Not while the audio thread is running. Blocks while it builds tables.
+    void prepare (const juce::dsp::ProcessSpec& spec);
+
+    // Clears the tail and jumps any parameter smoothing to its target. The
+    // lines are not touched: taps and loops simply skip samples written
+    // before the reset.
+    void reset() noexcept;
+
+    void setParameters (const Parameters& newParameters) noexcept;
+
+    // Message thread. Asks the builder for tables for a new DECAY and
+    // normalised ROOMSIZE; repeating the current values does nothing.
+    void requestTables (float decaySeconds, float roomSize);
+
+    // Not while the audio thread is running, and only once prepared. Builds
+    // tables for a new DECAY and normalised ROOMSIZE on the calling thread
+    // and clears the tail, for offline renders that reuse one engine.
+    void buildTablesNow (float decaySeconds, float roomSize);
+
+    // Writes the wet signal over the input.
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = (int) outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumSamples() == (size_t) numSamples);
+        outputBlock.copyFrom (inputBlock);
+
+        if (context.isBypassed || history == nullptr)
+            return;
+
+        if (numChannels == 1)
+            processChannels (outputBlock.getChannelPointer (0), nullptr, numSamples);
+        else if (numChannels == 2)
+            processChannels (outputBlock.getChannelPointer (0), outputBlock.getChannelPointer (1), numSamples);
+        else
+            jassertfalse; // only mono and stereo are supported
+    }
+
+    // Longest T60 the tables are built for.
+    static constexpr float maximumTailSeconds = 10.0f;
+
+private:
+    friend class VelvetTableBuilder;
+
+    static constexpr int maximumChannels = 2;
+    static constexpr int numLines = 3;
+    static constexpr int numTables = 4;
+    static constexpr int chunkSize = 256;
+
+    struct TapTable
+    {
+        struct Channel
+        {
+            // Grouped by line, each group in delay order.
+            std::vector<int> delays;
+            std::vector<float> gains;
+            std::array<int, (size_t) numLines + 1> lineStarts {};
+        };
+
+        std::array<Channel, (size_t) maximumChannels> channels;
+
+        // Per pass round each loop, for the table's T60.
+        std::array<float, (size_t) numLines> loopGains {};
+    };
+
+    // A table is free, being built, waiting to be picked up, playing, or
+    // fading out after being replaced.
+    enum class TableState { free, building, ready, live, fading };
+
+    static void generate (TapTable& table, double sampleRate, float decaySeconds, float roomSize);
+    static int getLoopLength (int line, double sampleRate) noexcept;
+
+    // Builder thread.
+    void buildPendingTable();
+
+    // With the builder cancelled: makes a table for the requested values the
+    // only one.
+    void resetTables();
+
+    void updateFilters() noexcept;
+    void takeReadyTable() noexcept;
+    void writeLines (const float* input, int numSamples) noexcept;
+    void renderTaps (const TapTable& table, int channel, int start, int numSamples, float* sum) noexcept;
+    void processChannels (float* left, float* right, int numSamples) noexcept;
+
+    juce::SharedResourcePointer<VelvetTableBuilder> builder;
+
+    std::array<TapTable, (size_t) numTables> tables;
+    std::array<std::atomic<TableState>, (size_t) numTables> tableStates;
+    std::atomic<int> readyTable { -1 };
+    int liveTable = 0;
+    int fadingTable = -1;
+
+    std::atomic<float> requestedDecay { 2.5f };
+    std::atomic<float> requestedRoomSize { 0.5f };
+
+    // Builder thread, or prepare() with the builder cancelled.
+    float builtDecay = -1.0f;
+    float builtRoomSize = -1.0f;
+
+    // The lines, historySize samples each, back to back.
+    juce::HeapBlock<float> history;
+    int historyCapacity = 0;
+    int historySize = 0;
+    int writePosition = 0;
+
+    // Samples written since the last reset, up to historySize; anything
+    // older reads as silence.
+    int validSamples = 0;
+
+    std::array<int, (size_t) numLines> loopLengths {};
+    std::array<float, (size_t) numLines> loopStates {};
+    std::array<float, (size_t) numLines> loopCoefficients {};
+
+    // The mono input, then the live and fading sums per channel, one chunk long.
+    juce::AudioBuffer<float> chunkBuffers { 1 + 2 * maximumChannels, chunkSize };
+
+    Parameters parameters;
+    double currentSampleRate = 0.0;
+    juce::SmoothedValue<float> wetGain1, wetGain2;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VelvetEngine)
+};
@@ -1,31 +1,191 @@
 #include "VisualizerComponent.h"
 #include <cmath>
 
-VisualizerComponent::VisualizerComponent (std::atomic<float>* roomSize,
-                                          std::atomic<float>* decay,
-                                          std::atomic<float>* damping)
-    : roomSizeParam (roomSize),
-      decayParam (decay),
-      dampingParam (damping)
+VisualizerComponent::VisualizerComponent (const juce::AudioProcessorValueTreeState& apvts,
+                                          ImpulseResponseRenderer::Client& impulseResponses,
+                                          WetSignalFifo* wet)
+    : parameters (apvts),
+      powerParam (apvts.getRawParameterValue ("POWER")),
+      renderer (impulseResponses),
+      wetSignal (wet)
 {
-    startTimerHz (60);
+    irWaveform.resize ((size_t) wavePoints);
+    irEnvelope.resize ((size_t) wavePoints);
+
+    renderer.addChangeListener (this);
+    checkForSettingsChange();
+    updateImpulseResponse();
+
+    lastActivityMs = juce::Time::getMillisecondCounterHiRes();
+}
+
+VisualizerComponent::~VisualizerComponent()
+{
+    renderer.removeChangeListener (this);
+    vBlankAttachment.reset();
+    setReadingWetSignal (false);
+}
+
+void VisualizerComponent::visibilityChanged()
+{
+    updateAnimationState();
+}
+
+void VisualizerComponent::parentHierarchyChanged()
+{
+    updateAnimationState();
+}
+
+void VisualizerComponent::mouseDown (const juce::MouseEvent& event)
+{
+    if (event.mods.isPopupMenu())
+        showFrameRateMenu();
+}
+
+void VisualizerComponent::showFrameRateMenu()
+{
+    const auto current = preferences->getMaximumFrameRate();
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader ("MAX FRAME RATE");
+
+    for (auto rate : EditorPreferences::getFrameRateChoices())
+        menu.addItem (rate, juce::String (rate) + " fps", true, rate == current);
+
+    juce::Component::SafePointer<VisualizerComponent> safeThis (this);
+    menu.showMenuAsync (juce::PopupMenu::Options().withTargetComponent (this),
+                        [safeThis] (int result)
+                        {
+                            if (safeThis != nullptr && result > 0)
+                                safeThis->preferences->setMaximumFrameRate (result);
+                        });
+}
+
+void VisualizerComponent::setReadingWetSignal (bool shouldRead)
+{
+    if (wetSignal == nullptr || shouldRead == isReadingWetSignal)
+        return;
+
+    isReadingWetSignal = shouldRead;
+
+    if (shouldRead)
+        wetSignal->addReader();
+    else
+        wetSignal->removeReader();
+}
+
+void VisualizerComponent::updateAnimationState()
+{
+    if (! isShowing())
+    {
+        // Keep a slow poll alive so we notice being un-minimised, but stop
+        // animating and let the audio thread skip the wet analysis.
+        vBlankAttachment.reset();
+        setReadingWetSignal (isDrivenExternally);
+        startTimerHz (idlePollHz);
+        return;
+    }
+
+    setReadingWetSignal (true);
+
+    if (hasSignalActivity())
+    {
+        stopTimer();
+
+        if (vBlankAttachment == nullptr)
+        {
+            lastFrameMs = juce::Time::getMillisecondCounterHiRes();
+            vBlankAttachment = std::make_unique<juce::VBlankAttachment> (this, [this] { advanceFrame(); });
+        }
+    }
+    else
+    {
+        vBlankAttachment.reset();
+        startTimerHz (idlePollHz);
+    }
+}
+
+bool VisualizerComponent::hasSignalActivity() const
+{
+    if (powerParam != nullptr && powerParam->load() <= 0.5f)
+        return false;
+
+    return juce::Time::getMillisecondCounterHiRes() - lastActivityMs < activityHoldMs;
+}
+
+void VisualizerComponent::resized()
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    clipPath.clear();
+    clipPath.addRoundedRectangle (bounds, cornerRadius);
+
+    backgroundLayer.invalidate();
+    updateImpulseResponsePaths();
+    updateParticles();
+    updateTailEnergyPaths();
 }
 
 void VisualizerComponent::paint (juce::Graphics& g)
 {
     auto bounds = getLocalBounds().toFloat();
-    const float radius = 12.0f;
 
+    backgroundLayer.draw (g, getLocalBounds(), [this] (juce::Graphics& layer) { renderBackground (layer); });
+
+    {
+        juce::Graphics::ScopedSaveState state (g);
+        g.reduceClipRegion (clipPath);
+
+        if (wetSignal != nullptr)
+        {
+            juce::ColourGradient fill (ObsidianStyle::accentViolet().withAlpha (0.28f), bounds.getX(), bounds.getY(),
+                                       ObsidianStyle::accentPurple().withAlpha (0.04f), bounds.getX(), bounds.getBottom(), false);
+            g.setGradientFill (fill);
+            g.fillPath (energyPath);
+
+            g.setColour (ObsidianStyle::accentLavender().withAlpha (0.35f));
+            g.strokePath (peakPath, juce::PathStrokeType (1.0f));
+        }
+
+        auto drawWave = [&g](const juce::Path& path, juce::Colour colour)
+        {
+            g.setColour (colour.withAlpha (colour.getFloatAlpha() * 0.35f));
+            g.strokePath (path, juce::PathStrokeType (6.0f));
+            g.setColour (colour.withAlpha (colour.getFloatAlpha() * 0.6f));
+            g.strokePath (path, juce::PathStrokeType (3.5f));
+            g.setColour (colour);
+            g.strokePath (path, juce::PathStrokeType (2.0f));
+        };
+
+        g.setColour (ObsidianStyle::accentPurple().withAlpha (0.18f));
+        g.fillPath (irEnvelopePath);
+        drawWave (irEnvelopePath, ObsidianStyle::accentViolet().withAlpha (0.4f));
+        drawWave (irWavePath, ObsidianStyle::accentLight().withAlpha (0.9f));
+
+        auto baseColour = ObsidianStyle::accentLight().withAlpha (0.6f);
+        for (auto particle : particles)
+        {
+            g.setColour (baseColour);
+            g.fillEllipse (particle.x - 2.0f, particle.y - 2.0f, 4.0f, 4.0f);
+            g.setColour (baseColour.withAlpha (0.25f));
+            g.fillEllipse (particle.x - 5.0f, particle.y - 5.0f, 10.0f, 10.0f);
+        }
+    }
+
+    g.setColour (ObsidianStyle::borderPurple());
+    g.drawRoundedRectangle (bounds, cornerRadius, 1.0f);
+}
+
+void VisualizerComponent::renderBackground (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
     juce::ColourGradient background (juce::Colour::fromRGB (0x0a, 0x0a, 0x0f),
                                      bounds.getX(), bounds.getY(),
                                      juce::Colour::fromRGB (0x05, 0x05, 0x08),
                                      bounds.getX(), bounds.getBottom(), false);
     g.setGradientFill (background);
-    g.fillRoundedRectangle (bounds, radius);
+    g.fillRoundedRectangle (bounds, cornerRadius);
 
-    juce::Path clipPath;
-    clipPath.addRoundedRectangle (bounds, radius);
-    juce::Graphics::ScopedSaveState state (g);
     g.reduceClipRegion (clipPath);
 
     g.setColour (ObsidianStyle::accentPurple().withAlpha (0.08f));
@@ -43,100 +203,253 @@ void VisualizerComponent::paint (juce::Graphics& g)
         auto y = bounds.getY() + bounds.getHeight() * (float) i / (float) horizontalDivs;
         g.drawLine (bounds.getX(), y, bounds.getRight(), y, 1.0f);
     }
+}
 
-    auto drawWave = [&g](const juce::Path& path, juce::Colour colour)
+void VisualizerComponent::timerCallback()
+{
+    if (isShowing())
     {
-        g.setColour (colour.withAlpha (colour.getFloatAlpha() * 0.35f));
-        g.strokePath (path, juce::PathStrokeType (6.0f));
-        g.setColour (colour.withAlpha (colour.getFloatAlpha() * 0.6f));
-        g.strokePath (path, juce::PathStrokeType (3.5f));
-        g.setColour (colour);
-        g.strokePath (path, juce::PathStrokeType (2.0f));
-    };
+        // Idle: only look for new activity, leave the frame as it is.
+        if (pullWetSignal())
+            updateTailEnergyPaths();
 
-    drawWave (createWavePath (phase + 0.2f, -10.0f), ObsidianStyle::accentPurple().withAlpha (0.3f));
-    drawWave (createWavePath (phase + 0.6f, -5.0f), ObsidianStyle::accentViolet().withAlpha (0.4f));
-    drawWave (createWavePath (phase + 1.0f, 2.0f), ObsidianStyle::accentLavender().withAlpha (0.6f));
-    drawWave (createWavePath (phase + 1.4f, 6.0f), ObsidianStyle::accentLight().withAlpha (0.9f));
+        checkForSettingsChange();
+    }
 
-    const int particleCount = 12;
-    for (int i = 0; i < particleCount; ++i)
-    {
-        auto t = (float) i / (float) (particleCount - 1);
-        auto x = bounds.getX() + t * bounds.getWidth();
-
-        auto waveY = bounds.getCentreY();
-        auto decayValue = decayParam ? decayParam->load() : 2.5f;
-        auto dampingValue = dampingParam ? dampingParam->load() : 8000.0f;
-        auto roomValue = roomSizeParam ? roomSizeParam->load() : 50.0f;
-
-        auto decayNorm = juce::jlimit (0.0f, 1.0f, (decayValue - 0.1f) / 9.9f);
-        auto dampingNorm = juce::jlimit (0.0f, 1.0f,
-                                         (std::log (dampingValue) - std::log (1000.0f)) /
-                                         (std::log (20000.0f) - std::log (1000.0f)));
-        auto decayFactor = 3.0f + decayNorm * 7.0f;
-        auto dampingFactor = 1.0f - dampingNorm * 0.5f;
-        auto freq1 = 25.0f * (1.0f + roomValue / 100.0f);
-        auto freq2 = 15.0f * (1.0f + roomValue / 150.0f);
-        auto envelope = std::exp (-t * decayFactor);
-        auto oscillation = (std::sin (t * freq1 + phase) * 0.6f + std::sin (t * freq2 - phase * 0.5f) * 0.4f)
-                           * envelope * dampingFactor;
-        waveY += oscillation * (bounds.getHeight() * 0.35f);
+    updateAnimationState();
+}
 
-        auto baseColour = ObsidianStyle::accentLight().withAlpha (0.6f);
-        g.setColour (baseColour);
-        g.fillEllipse (x - 2.0f, waveY - 2.0f, 4.0f, 4.0f);
-        g.setColour (baseColour.withAlpha (0.25f));
-        g.fillEllipse (x - 5.0f, waveY - 5.0f, 10.0f, 10.0f);
-    }
+void VisualizerComponent::advanceFrame()
+{
+    const auto now = juce::Time::getMillisecondCounterHiRes();
+    const auto frameIntervalMs = 1000.0 / (double) preferences->getMaximumFrameRate();
 
-    g.setColour (ObsidianStyle::borderPurple());
-    g.drawRoundedRectangle (bounds, radius, 1.0f);
+    // Allow a little slack so a 60 fps cap on a 60 Hz display doesn't drop
+    // every other vblank because of jitter.
+    if (now - lastFrameMs < frameIntervalMs * 0.9)
+        return;
+
+    const auto elapsedMs = juce::jmin (100.0, now - lastFrameMs);
+    lastFrameMs = now;
+
+    stepAnimation (elapsedMs);
+
+    if (! hasSignalActivity())
+        updateAnimationState();
 }
 
-void VisualizerComponent::timerCallback()
+void VisualizerComponent::advanceFrameExternally (double elapsedMs)
 {
-    phase += 0.02f;
+    isDrivenExternally = true;
+    setReadingWetSignal (true);
+    stepAnimation (elapsedMs);
+}
+
+void VisualizerComponent::stepAnimation (double elapsedMs)
+{
+    auto dirty = getAnimatedBounds();
+
+    if (pullWetSignal())
+    {
+        dirty = dirty.getUnion (energyPath.getBounds()).getUnion (peakPath.getBounds());
+        updateTailEnergyPaths();
+        dirty = dirty.getUnion (energyPath.getBounds()).getUnion (peakPath.getBounds());
+    }
+
+    checkForSettingsChange();
+
+    // Same drift speed as the original 0.02 rad per 60 Hz tick, at any frame rate.
+    phase += 0.02f * (float) (elapsedMs * 60.0 / 1000.0);
     if (phase > juce::MathConstants<float>::twoPi)
         phase -= juce::MathConstants<float>::twoPi;
+
+    updateParticles();
+    dirty = dirty.getUnion (getAnimatedBounds());
+
+    repaint (dirty.getSmallestIntegerContainer().getIntersection (getLocalBounds()));
+}
+
+juce::Rectangle<float> VisualizerComponent::getAnimatedBounds() const
+{
+    juce::Rectangle<float> area;
+
+    for (auto particle : particles)
+        area = area.getUnion ({ particle.x - 5.0f, particle.y - 5.0f, 10.0f, 10.0f });
+
+    return area.expanded (1.0f);
+}
+
+void VisualizerComponent::checkForSettingsChange()
+{
+    auto settings = ReverbSettings::fromParameters (parameters);
+    auto hash = settings.getTailHash();
+
+    if (hash != requestedHash)
+    {
+        requestedHash = hash;
+        renderer.requestRender (settings);
+        lastActivityMs = juce::Time::getMillisecondCounterHiRes();
+    }
+}
+
+void VisualizerComponent::changeListenerCallback (juce::ChangeBroadcaster* source)
+{
+    juce::ignoreUnused (source);
+
+    // Decay bands filling in leave the waveform as it was.
+    auto ir = renderer.getLatestResult();
+    if (ir != nullptr && ir->hash == displayedHash)
+        return;
+
+    updateImpulseResponse();
+    updateImpulseResponsePaths();
+    updateParticles();
+    lastActivityMs = juce::Time::getMillisecondCounterHiRes();
     repaint();
+    updateAnimationState();
+}
+
+void VisualizerComponent::updateImpulseResponse()
+{
+    auto ir = renderer.getLatestResult();
+
+    if (ir == nullptr)
+    {
+        displayedHash = 0;
+        std::fill (irWaveform.begin(), irWaveform.end(), 0.0f);
+        std::fill (irEnvelope.begin(), irEnvelope.end(), 0.0f);
+        return;
+    }
+
+    // Reduce the renderer's peaks to one per display point, keeping the signed
+    // peak of largest magnitude for the waveform and its size for the envelope.
+    const auto numPeaks = ImpulseResponseDisplay::numPeaks;
+    float loudest = 0.0f;
+    displayedHash = ir->hash;
+
+    for (int point = 0; point < wavePoints; ++point)
+    {
+        const auto start = numPeaks * point / wavePoints;
+        const auto end = juce::jmax (start + 1, numPeaks * (point + 1) / wavePoints);
+        float peak = 0.0f;
+
+        for (int i = start; i < end; ++i)
+            if (std::abs (ir->peaks[(size_t) i]) > std::abs (peak))
+                peak = ir->peaks[(size_t) i];
+
+        irWaveform[(size_t) point] = peak;
+        irEnvelope[(size_t) point] = std::abs (peak);
+        loudest = juce::jmax (loudest, std::abs (peak));
+    }
+
+    if (loudest > 0.0f)
+    {
+        juce::FloatVectorOperations::multiply (irWaveform.data(), 1.0f / loudest, wavePoints);
+        juce::FloatVectorOperations::multiply (irEnvelope.data(), 1.0f / loudest, wavePoints);
+    }
+
+    // Smooth the envelope into a readable decay contour.
+    for (int point = 1; point < wavePoints; ++point)
+        irEnvelope[(size_t) point] = juce::jmax (irEnvelope[(size_t) point], irEnvelope[(size_t) (point - 1)] * 0.9f);
 }
 
-juce::Path VisualizerComponent::createWavePath (float phaseOffset, float offset) const
+void VisualizerComponent::updateImpulseResponsePaths()
 {
     auto bounds = getLocalBounds().toFloat().reduced (6.0f, 4.0f);
     auto centreY = bounds.getCentreY();
-    const int points = 300;
-
-    auto roomValue = roomSizeParam ? roomSizeParam->load() : 50.0f;
-    auto decayValue = decayParam ? decayParam->load() : 2.5f;
-    auto dampingValue = dampingParam ? dampingParam->load() : 8000.0f;
-
-    auto decayNorm = juce::jlimit (0.0f, 1.0f, (decayValue - 0.1f) / 9.9f);
-    auto dampingNorm = juce::jlimit (0.0f, 1.0f,
-                                     (std::log (dampingValue) - std::log (1000.0f)) /
-                                     (std::log (20000.0f) - std::log (1000.0f)));
-    auto decayFactor = 3.0f + decayNorm * 7.0f;
-    auto dampingFactor = 1.0f - dampingNorm * 0.5f;
-    auto freq1 = 25.0f * (1.0f + roomValue / 100.0f);
-    auto freq2 = 15.0f * (1.0f + roomValue / 150.0f);
-
-    juce::Path path;
-    for (int i = 0; i < points; ++i)
-    {
-        auto t = (float) i / (float) (points - 1);
-        auto x = bounds.getX() + t * bounds.getWidth();
-        auto envelope = std::exp (-t * decayFactor);
-        auto oscillation = (std::sin (t * freq1 + phaseOffset) * 0.6f
-                            + std::sin (t * freq2 - phaseOffset * 0.5f) * 0.4f)
-                           * envelope * dampingFactor;
-        auto y = centreY + oscillation * (bounds.getHeight() * 0.35f) + offset;
+    auto amplitude = bounds.getHeight() * 0.4f;
+
+    irWavePath.clear();
+    irEnvelopePath.clear();
+    irWavePath.preallocateSpace (wavePoints * 3);
+    irEnvelopePath.preallocateSpace (wavePoints * 6 + 4);
+
+    auto xForPoint = [&] (int point) { return bounds.getX() + bounds.getWidth() * (float) point / (float) (wavePoints - 1); };
+
+    irWavePath.startNewSubPath (xForPoint (0), centreY - irWaveform[0] * amplitude);
+    irEnvelopePath.startNewSubPath (xForPoint (0), centreY - irEnvelope[0] * amplitude);
+
+    for (int point = 1; point < wavePoints; ++point)
+    {
+        irWavePath.lineTo (xForPoint (point), centreY - irWaveform[(size_t) point] * amplitude);
+        irEnvelopePath.lineTo (xForPoint (point), centreY - irEnvelope[(size_t) point] * amplitude);
+    }
+
+    for (int point = wavePoints; --point >= 0;)
+        irEnvelopePath.lineTo (xForPoint (point), centreY + irEnvelope[(size_t) point] * amplitude);
+
+    irEnvelopePath.closeSubPath();
+}
+
+void VisualizerComponent::updateParticles()
+{
+    // Particles drift along the top of the decay envelope.
+    auto bounds = getLocalBounds().toFloat().reduced (6.0f, 4.0f);
+    auto amplitude = bounds.getHeight() * 0.4f;
+    auto drift = phase / juce::MathConstants<float>::twoPi;
+
+    for (int i = 0; i < particleCount; ++i)
+    {
+        auto t = std::fmod ((float) i / (float) particleCount + drift, 1.0f);
+        auto position = t * (float) (wavePoints - 1);
+        auto index = juce::jmin ((int) position, wavePoints - 2);
+        auto fraction = position - (float) index;
+        auto level = irEnvelope[(size_t) index] + (irEnvelope[(size_t) index + 1] - irEnvelope[(size_t) index]) * fraction;
+
+        particles[(size_t) i] = { bounds.getX() + t * bounds.getWidth(), bounds.getCentreY() - level * amplitude };
+    }
+}
+
+bool VisualizerComponent::pullWetSignal()
+{
+    if (wetSignal == nullptr)
+        return false;
+
+    const auto numFrames = wetSignal->pullFrames (incoming.data(), historySize);
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        const auto& frame = incoming[(size_t) i];
+        history[(size_t) historyWritePosition] = frame;
+        historyWritePosition = (historyWritePosition + 1) % historySize;
+
+        if (frame.peak > silenceThreshold)
+            lastActivityMs = juce::Time::getMillisecondCounterHiRes();
+    }
+
+    return numFrames > 0;
+}
+
+void VisualizerComponent::updateTailEnergyPaths()
+{
+    auto area = getLocalBounds().toFloat();
+    const float floorDb = -72.0f;
+
+    auto levelToY = [&] (float level)
+    {
+        auto db = juce::jlimit (floorDb, 0.0f, juce::Decibels::gainToDecibels (level, floorDb));
+        return juce::jmap (db, floorDb, 0.0f, area.getBottom(), area.getY() + area.getHeight() * 0.1f);
+    };
+
+    energyPath.clear();
+    peakPath.clear();
+    energyPath.preallocateSpace (historySize * 3 + 8);
+    peakPath.preallocateSpace (historySize * 3);
+    energyPath.startNewSubPath (area.getX(), area.getBottom());
+
+    for (int i = 0; i < historySize; ++i)
+    {
+        const auto& frame = history[(size_t) ((historyWritePosition + i) % historySize)];
+        auto x = area.getX() + area.getWidth() * (float) i / (float) (historySize - 1);
+
+        energyPath.lineTo (x, levelToY (frame.rms));
 
         if (i == 0)
-            path.startNewSubPath (x, y);
+            peakPath.startNewSubPath (x, levelToY (frame.peak));
         else
-            path.lineTo (x, y);
+            peakPath.lineTo (x, levelToY (frame.peak));
     }
 
-    return path;
+    energyPath.lineTo (area.getRight(), area.getBottom());
+    energyPath.closeSubPath();
 }
@@ -2,24 +2,94 @@
 
 #include <JuceHeader.h>
 #include "ObsidianSpaceLookAndFeel.h"
+#include "WetSignalFifo.h"
+#include "EditorPreferences.h"
+#include "ImpulseResponseRenderer.h"
+#include "CachedLayer.h"
 
 class VisualizerComponent : public juce::Component,
-                            private juce::Timer
+                            private juce::Timer,
+                            private juce::ChangeListener
 {
 public:
-    VisualizerComponent (std::atomic<float>* roomSizeParam,
-                         std::atomic<float>* decayParam,
-                         std::atomic<float>* dampingParam);
+    VisualizerComponent (const juce::AudioProcessorValueTreeState& apvts,
+                         ImpulseResponseRenderer::Client& impulseResponses,
+                         WetSignalFifo* wetSignal);
+    ~VisualizerComponent() override;
 
     void paint (juce::Graphics& g) override;
+    void resized() override;
+    void mouseDown (const juce::MouseEvent& event) override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
+
+    // For offscreen use, such as benchmarks, where no display drives the
+    // animation: keeps reading the wet signal while hidden, and steps one
+    // frame per call.
+    void advanceFrameExternally (double elapsedMs);
 
 private:
     void timerCallback() override;
-    juce::Path createWavePath (float phase, float offset) const;
+    void updateAnimationState();
+    void setReadingWetSignal (bool shouldRead);
+    bool hasSignalActivity() const;
+    void advanceFrame();
+    void stepAnimation (double elapsedMs);
+    void showFrameRateMenu();
+    juce::Rectangle<float> getAnimatedBounds() const;
+
+    void changeListenerCallback (juce::ChangeBroadcaster* source) override;
+    void checkForSettingsChange();
+    void updateImpulseResponse();
+    void updateImpulseResponsePaths();
+    void updateParticles();
+    void renderBackground (juce::Graphics& g);
+
+    bool pullWetSignal();
+    void updateTailEnergyPaths();
+
+    const juce::AudioProcessorValueTreeState& parameters;
+    std::atomic<float>* powerParam = nullptr;
+
+    ImpulseResponseRenderer::Client& renderer;
+    juce::uint64 requestedHash = 0;
+    juce::uint64 displayedHash = 0;
+
+    WetSignalFifo* wetSignal = nullptr;
+    bool isReadingWetSignal = false;
+    bool isDrivenExternally = false;
+
+    // Animation runs from the display's vblank while there is something to
+    // show, and falls back to a slow poll that only looks for new activity.
+    juce::SharedResourcePointer<EditorPreferences> preferences;
+    std::unique_ptr<juce::VBlankAttachment> vBlankAttachment;
+    static constexpr int idlePollHz = 4;
+    static constexpr double activityHoldMs = 750.0;
+    static constexpr float silenceThreshold = 0.0003f; // about -70 dB
+    double lastActivityMs = 0.0;
+    double lastFrameMs = 0.0;
+
+    // Most recent wet envelope frames, oldest first once the history is full.
+    static constexpr int historySize = 512;
+    std::array<WetSignalFifo::Frame, (size_t) historySize> history {};
+    std::array<WetSignalFifo::Frame, (size_t) historySize> incoming {};
+    int historyWritePosition = 0;
+
+    static constexpr int wavePoints = 300;
+    static constexpr int particleCount = 12;
+    static constexpr float cornerRadius = 12.0f;
+
+    // The current impulse response reduced to one signed peak and one
+    // envelope value per display point, normalised to the loudest point.
+    std::vector<float> irWaveform, irEnvelope;
+    juce::Path irWavePath, irEnvelopePath;
+    std::array<juce::Point<float>, (size_t) particleCount> particles;
+
+    juce::Path clipPath;
+    juce::Path energyPath, peakPath;
 
-    std::atomic<float>* roomSizeParam = nullptr;
-    std::atomic<float>* decayParam = nullptr;
-    std::atomic<float>* dampingParam = nullptr;
+    // Gradient background and grid.
+    CachedLayer backgroundLayer;
 
     float phase = 0.0f;
 };
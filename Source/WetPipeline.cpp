@@ -0,0 +1,248 @@
+#include "WetPipeline.h"
+
+WetPipeline::WetPipeline (Stage& stageToRun)
+    : juce::Thread ("Obsidian Space Wet Pipeline"),
+      stage (stageToRun)
+{
+}
+
+WetPipeline::~WetPipeline()
+{
+    stop();
+}
+
+void WetPipeline::start (double sampleRate, int blockSize, int numChannels)
+{
+    jassert (sampleRate > 0.0 && blockSize > 0 && numChannels > 0);
+    stop();
+
+    latency = blockSize;
+    chunkSize = blockSize;
+    channels = numChannels;
+    secondsPerSample = 1.0 / sampleRate;
+
+    const auto capacity = blockSize * fifoBlocks + 1;
+    inputFifo.setTotalSize (capacity);
+    outputFifo.setTotalSize (capacity);
+    inputRing.setSize (numChannels, capacity, false, true);
+    outputRing.setSize (numChannels, capacity, false, true);
+    scratch.setSize (numChannels, blockSize, false, true);
+
+    samplesSubmitted = 0;
+    readPosition = 0;
+    isRestarting = false;
+    samplesProcessed.store (0, std::memory_order_relaxed);
+    resetPending.store (false, std::memory_order_relaxed);
+    isWorkerSleeping.store (false, std::memory_order_relaxed);
+    lateBlocks.store (0, std::memory_order_relaxed);
+
+    if (! startRealtimeThread (juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime (blockSize, sampleRate)))
+        startThread (juce::Thread::Priority::highest);
+}
+
+void WetPipeline::stop()
+{
+    stopThread (1000);
+}
+
+void WetPipeline::reset() noexcept
+{
+    resetPending.store (true, std::memory_order_release);
+    isRestarting = true;
+}
+
+//==============================================================================
+void WetPipeline::process (juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, bool waitForWorker) noexcept
+{
+    jassert (numChannels == channels);
+
+    // Starting over waits, without blocking, for the worker to go idle;
+    // whatever it made until then is stale, and is dropped as it arrives so
+    // the worker never runs out of room.
+    if (isRestarting)
+    {
+        outputFifo.finishedRead (outputFifo.getNumReady());
+
+        if (waitForWorker)
+            waitUntilProcessed (samplesSubmitted);
+
+        if (samplesProcessed.load (std::memory_order_acquire) != samplesSubmitted)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                buffer.clear (channel, 0, numSamples);
+
+            return;
+        }
+
+        outputFifo.finishedRead (outputFifo.getNumReady());
+        readPosition = samplesSubmitted;
+        isRestarting = false;
+    }
+
+    if (inputFifo.getFreeSpace() < numSamples)
+    {
+        lateBlocks.fetch_add (1, std::memory_order_relaxed);
+        isRestarting = true;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.clear (channel, 0, numSamples);
+
+        return;
+    }
+
+    const auto firstPosition = samplesSubmitted - latency;
+    write (inputFifo, inputRing, buffer, numChannels, numSamples);
+    samplesSubmitted += numSamples;
+
+    if (isWorkerSleeping.load())
+        notify();
+
+    if (waitForWorker)
+        waitUntilProcessed (firstPosition + numSamples);
+
+    readWet (buffer, numChannels, numSamples, firstPosition);
+}
+
+void WetPipeline::readWet (juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, juce::int64 firstPosition) noexcept
+{
+    // Skip wet samples that arrived too late to be played.
+    if (readPosition < firstPosition)
+    {
+        const auto late = (int) juce::jmin ((juce::int64) outputFifo.getNumReady(), firstPosition - readPosition);
+        outputFifo.finishedRead (late);
+        readPosition += late;
+    }
+
+    // Right after a start there is nothing to play for the first block.
+    auto start = readPosition < firstPosition ? 0 : (int) juce::jmin ((juce::int64) numSamples, readPosition - firstPosition);
+
+    const auto numReady = readPosition < firstPosition ? 0 : juce::jmin (outputFifo.getNumReady(), numSamples - start);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        buffer.clear (channel, 0, start);
+
+    read (outputFifo, outputRing, buffer, start, numChannels, numReady);
+    readPosition += numReady;
+    start += numReady;
+
+    if (start == numSamples)
+        return;
+
+    lateBlocks.fetch_add (1, std::memory_order_relaxed);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        buffer.clear (channel, start, numSamples - start);
+}
+
+void WetPipeline::waitUntilProcessed (juce::int64 position) noexcept
+{
+    // Offline only, where the audio thread may block. The worker signals
+    // after each chunk while someone is waiting.
+    while (samplesProcessed.load() < position)
+    {
+        isCallerWaiting.store (true);
+
+        if (samplesProcessed.load() < position)
+            chunkProcessed.wait (100);
+
+        isCallerWaiting.store (false);
+    }
+}
+
+//==============================================================================
+void WetPipeline::run()
+{
+    juce::ScopedNoDenormals noDenormals;
+    auto idleSinceTicks = juce::Time::getHighResolutionTicks();
+
+    while (! threadShouldExit())
+    {
+        if (resetPending.exchange (false, std::memory_order_acq_rel))
+            stage.resetWet();
+
+        const auto numSamples = juce::jmin (inputFifo.getNumReady(), outputFifo.getFreeSpace(), chunkSize);
+
+        if (numSamples > 0)
+        {
+            processChunk (numSamples);
+            idleSinceTicks = juce::Time::getHighResolutionTicks();
+            continue;
+        }
+
+        // A short spin catches input that is already on its way; past that
+        // the worker sleeps until process() wakes it, so an idle pipeline
+        // never holds a core.
+        if ((double) (juce::Time::getHighResolutionTicks() - idleSinceTicks) * secondsPerTick < spinSeconds)
+        {
+            juce::Thread::yield();
+            continue;
+        }
+
+        isWorkerSleeping.store (true);
+
+        if (inputFifo.getNumReady() == 0)
+            wait (100);
+
+        isWorkerSleeping.store (false);
+        idleSinceTicks = juce::Time::getHighResolutionTicks();
+    }
+}
+
+void WetPipeline::processChunk (int numSamples)
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    read (inputFifo, inputRing, scratch, 0, channels, numSamples);
+
+    auto block = juce::dsp::AudioBlock<float> (scratch).getSubBlock (0, (size_t) numSamples);
+    stage.processWet (block, channels, numSamples);
+
+    write (outputFifo, outputRing, scratch, channels, numSamples);
+    samplesProcessed.fetch_add (numSamples);
+
+    if (isCallerWaiting.load())
+        chunkProcessed.signal();
+
+    const auto elapsedSeconds = (double) (juce::Time::getHighResolutionTicks() - startTicks) * secondsPerTick;
+    lastChunkLoad = (float) (elapsedSeconds / ((double) numSamples * secondsPerSample));
+    lastChunkSize = numSamples;
+}
+
+//==============================================================================
+void WetPipeline::write (juce::AbstractFifo& fifo, juce::AudioBuffer<float>& ring,
+                         const juce::AudioBuffer<float>& source, int numChannels, int numSamples) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+    jassert (size1 + size2 == numSamples);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        ring.copyFrom (channel, start1, source, channel, 0, size1);
+
+        if (size2 > 0)
+            ring.copyFrom (channel, start2, source, channel, size1, size2);
+    }
+
+    fifo.finishedWrite (size1 + size2);
+}
+
+void WetPipeline::read (juce::AbstractFifo& fifo, const juce::AudioBuffer<float>& ring,
+                        juce::AudioBuffer<float>& destination, int destinationStart, int numChannels, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (numSamples, start1, size1, start2, size2);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        destination.copyFrom (channel, destinationStart, ring, channel, start1, size1);
+
+        if (size2 > 0)
+            destination.copyFrom (channel, destinationStart + size1, ring, channel, start2, size2);
+    }
+
+    fifo.finishedRead (size1 + size2);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Runs an instance's wet path on its own real-time thread, overlapped with
+// the audio thread. Each callback queues its input and takes back the wet
+// signal the worker made from input exactly getLatencySamples() earlier.
+// Both directions go through single-producer, single-consumer FIFOs, so the
+// audio thread never waits on the worker. If the worker falls behind, the
+// late wet samples play as silence and are skipped when they arrive, so the
+// latency never drifts. Offline, where there is no deadline, the caller can
+// wait for the worker instead, with the same latency.
+class WetPipeline : private juce::Thread
+{
+public:
+    // Called on the worker while the pipeline runs; nothing else may touch
+    // the state these process until it is stopped.
+    struct Stage
+    {
+        virtual ~Stage() = default;
+        virtual void processWet (juce::dsp::AudioBlock<float>& block, int numChannels, int numSamples) = 0;
+        virtual void resetWet() = 0;
+    };
+
+    explicit WetPipeline (Stage& stageToRun);
+    ~WetPipeline() override;
+
+    // Message thread, with the audio thread stopped. The latency is one
+    // block of blockSize samples.
+    void start (double sampleRate, int blockSize, int numChannels);
+    void stop();
+
+    int getLatencySamples() const noexcept { return latency; }
+
+    // Audio thread. Replaces the first numChannels of buffer with wet signal,
+    // blocking until the worker has made all of it if waitForWorker is set.
+    void process (juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, bool waitForWorker = false) noexcept;
+
+    // Audio thread. The worker resets the stage before its next chunk, and
+    // the wet signal queued until then is dropped.
+    void reset() noexcept;
+
+    // Worker thread: how long the last chunk took over its duration.
+    float getLastChunkLoad() const noexcept { return lastChunkLoad; }
+    int getLastChunkSize() const noexcept { return lastChunkSize; }
+
+    // Callbacks that played some silence because the worker was late.
+    juce::uint32 getNumLateBlocks() const noexcept { return lateBlocks.load (std::memory_order_relaxed); }
+
+private:
+    void run() override;
+    void processChunk (int numSamples);
+    void waitUntilProcessed (juce::int64 position) noexcept;
+    void readWet (juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, juce::int64 firstPosition) noexcept;
+
+    static void write (juce::AbstractFifo& fifo, juce::AudioBuffer<float>& ring,
+                       const juce::AudioBuffer<float>& source, int numChannels, int numSamples) noexcept;
+    static void read (juce::AbstractFifo& fifo, const juce::AudioBuffer<float>& ring,
+                      juce::AudioBuffer<float>& destination, int destinationStart, int numChannels, int numSamples) noexcept;
+
+    // The FIFOs hold this many blocks; a worker further behind than that
+    // has stalled, and the pipeline starts over.
+    static constexpr int fifoBlocks = 8;
+
+    // How long the worker spins for more input before it sleeps.
+    static constexpr double spinSeconds = 0.00002;
+
+    Stage& stage;
+    int latency = 0;
+    int chunkSize = 0;
+    int channels = 0;
+    double secondsPerSample = 1.0 / 44100.0;
+    const double secondsPerTick = 1.0 / (double) juce::Time::getHighResolutionTicksPerSecond();
+
+    juce::AbstractFifo inputFifo { 1 }, outputFifo { 1 };
+    juce::AudioBuffer<float> inputRing, outputRing, scratch;
+
+    // Audio thread: stream positions of the next input sample queued and
+    // the next wet sample in outputFifo.
+    juce::int64 samplesSubmitted = 0;
+    juce::int64 readPosition = 0;
+    bool isRestarting = false;
+
+    std::atomic<juce::int64> samplesProcessed { 0 };
+    std::atomic<bool> resetPending { false };
+    std::atomic<bool> isWorkerSleeping { false };
+    std::atomic<bool> isCallerWaiting { false };
+    juce::WaitableEvent chunkProcessed;
+    std::atomic<juce::uint32> lateBlocks { 0 };
+
+    float lastChunkLoad = 0.0f;
+    int lastChunkSize = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WetPipeline)
+};
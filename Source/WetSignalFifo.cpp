@@ -0,0 +1,108 @@
+#include "WetSignalFifo.h"
+
+namespace
+{
+    float sumOfSquares (const float* data, int numSamples) noexcept
+    {
+        // Four independent accumulators so the loop pipelines and vectorises.
+        float acc0 = 0.0f, acc1 = 0.0f, acc2 = 0.0f, acc3 = 0.0f;
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            acc0 += data[i]     * data[i];
+            acc1 += data[i + 1] * data[i + 1];
+            acc2 += data[i + 2] * data[i + 2];
+            acc3 += data[i + 3] * data[i + 3];
+        }
+
+        for (; i < numSamples; ++i)
+            acc0 += data[i] * data[i];
+
+        return (acc0 + acc1) + (acc2 + acc3);
+    }
+}
+
+void WetSignalFifo::prepare (double sampleRate)
+{
+    currentSampleRate.store (sampleRate, std::memory_order_relaxed);
+    pendingPeak = 0.0f;
+    pendingSumOfSquares = 0.0f;
+    pendingSamples = 0;
+}
+
+void WetSignalFifo::pushBlock (const juce::dsp::AudioBlock<float>& wetBlock) noexcept
+{
+    const auto numChannels = (int) wetBlock.getNumChannels();
+    const auto numSamples = (int) wetBlock.getNumSamples();
+
+    if (numChannels == 0)
+        return;
+
+    const auto channelScale = 1.0f / (float) numChannels;
+    int position = 0;
+
+    while (position < numSamples)
+    {
+        const auto segment = juce::jmin (numSamples - position, samplesPerFrame - pendingSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* data = wetBlock.getChannelPointer ((size_t) channel) + position;
+            auto range = juce::FloatVectorOperations::findMinAndMax (data, segment);
+            pendingPeak = juce::jmax (pendingPeak, -range.getStart(), range.getEnd());
+            pendingSumOfSquares += sumOfSquares (data, segment) * channelScale;
+        }
+
+        pendingSamples += segment;
+        position += segment;
+
+        if (pendingSamples == samplesPerFrame)
+        {
+            pushFrame ({ pendingPeak, std::sqrt (pendingSumOfSquares / (float) samplesPerFrame) });
+            pendingPeak = 0.0f;
+            pendingSumOfSquares = 0.0f;
+            pendingSamples = 0;
+        }
+    }
+}
+
+void WetSignalFifo::pushFrame (Frame frame) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    // If the editor has stopped reading, drop frames rather than block.
+    if (size1 > 0)
+    {
+        frames[(size_t) start1] = frame;
+        fifo.finishedWrite (1);
+    }
+}
+
+void WetSignalFifo::addReader() noexcept
+{
+    activeReaders.fetch_add (1, std::memory_order_relaxed);
+}
+
+void WetSignalFifo::removeReader() noexcept
+{
+    activeReaders.fetch_sub (1, std::memory_order_relaxed);
+}
+
+int WetSignalFifo::pullFrames (Frame* destination, int maxFrames) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (maxFrames, start1, size1, start2, size2);
+
+    std::copy_n (frames.begin() + start1, size1, destination);
+    std::copy_n (frames.begin() + start2, size2, destination + size1);
+    fifo.finishedRead (size1 + size2);
+
+    return size1 + size2;
+}
+
+double WetSignalFifo::getFramesPerSecond() const noexcept
+{
+    return currentSampleRate.load (std::memory_order_relaxed) / (double) samplesPerFrame;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// Carries a decimated envelope of the wet signal from the audio thread to the
+// editor. Single producer (processBlock), single consumer (the UI timer).
+// Nothing is measured while no editor has registered itself as a reader.
+class WetSignalFifo
+{
+public:
+    struct Frame
+    {
+        float peak = 0.0f;
+        float rms = 0.0f;
+    };
+
+    static constexpr int samplesPerFrame = 256;
+
+    void prepare (double sampleRate);
+
+    // Audio thread.
+    bool isActive() const noexcept { return activeReaders.load (std::memory_order_relaxed) > 0; }
+    void pushBlock (const juce::dsp::AudioBlock<float>& wetBlock) noexcept;
+
+    // Message thread.
+    void addReader() noexcept;
+    void removeReader() noexcept;
+    int pullFrames (Frame* destination, int maxFrames) noexcept;
+    double getFramesPerSecond() const noexcept;
+
+private:
+    void pushFrame (Frame frame) noexcept;
+
+    static constexpr int capacity = 1024;
+
+    juce::AbstractFifo fifo { capacity };
+    std::array<Frame, (size_t) capacity> frames;
+
+    std::atomic<int> activeReaders { 0 };
+    std::atomic<double> currentSampleRate { 44100.0 };
+
+    // Partially filled frame, owned by the audio thread.
+    float pendingPeak = 0.0f;
+    float pendingSumOfSquares = 0.0f;
+    int pendingSamples = 0;
+};